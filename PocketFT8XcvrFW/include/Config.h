@@ -23,6 +23,10 @@ typedef struct Config {
     char m1[14];                           // Free Text Message 1 and NUL
     char m2[14];                           // Free Text Message 2 and NUL
     char my_sota_ref[12];                  // My station's SOTA Reference
+    unsigned syncSearch;                   // 0=exhaustive, 1=coarse-to-fine find_sync() (see SyncSearch)
+    unsigned decodeBudgetMs;               // mS ft8_decode() may run past the timeslot's last symbol, 0=whole timeslot
+    unsigned earlyDecode;                  // Symbols received before ft8_decode_early() runs, 0=disabled
+    unsigned sicPasses;                    // ft8_decode() passes, each after subtracting the last's signals
 } ConfigType;
 
 // Default configuration
@@ -38,6 +42,10 @@ typedef struct Config {
 #define DEFAULT_ENABLE_DUPLICATES false       // RoboOp will not contact duplicates
 #define DEFAULT_LOG_FILENAME "LOGFILE.ADIF"   // Default ADIF Log Filename
 #define DEFAULT_MY_NAME ""                    // Operator's personal name (not callsign)
+#define DEFAULT_SYNC_SEARCH 0                 // Exhaustive Costas sync search
+#define DEFAULT_DECODE_BUDGET_MS 1200         // Decodes finish by 0.92 S into the next timeslot
+#define DEFAULT_EARLY_DECODE 74               // 11.84 S, when WSJT-X decodes early
+#define DEFAULT_SIC_PASSES 1                  // A single pass, without interference cancellation
 
 void readConfigFile(void);
 unsigned getLowerBandLimit(unsigned f);  // Calculate lower band limit for operating frequency f
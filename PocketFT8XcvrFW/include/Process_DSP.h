@@ -1,3 +1,5 @@
+#pragma once
+
 
 #include "arm_math.h"
 
@@ -5,12 +7,18 @@
 #define num_que_blocks 8
 #define block_size 128
 #define input_gulp_size 1024
+#define audio_ring_size 4096  // Power of two holding the 3 gulps windowed by extract_power()
 
 #define ft8_buffer 400  // arbitrary for 3 kc
 #define ft8_min_bin 48
 #define FFT_Resolution 6.25
 #define ft8_min_freq FFT_Resolution* ft8_min_bin
 
+// The spectrogram's columns ft8_min_bin..ft8_buffer-1 (plus the FFT bin above them for averaging) are all
+// the decoder and waterfall ever read, so extract_power() only processes these FFT bins
+#define ft8_first_fft_bin (2 * ft8_min_bin)
+#define ft8_fft_bins (2 * (ft8_buffer - ft8_min_bin) + 1)
+
 // Define the number of message samples.  To the best of my knowledge:
 //   + The audio pipeline queues blocks of time domain samples at the rate of 6400 samples/second
 //   + Each queue block contains 128 16-bit samples (256 bytes)
@@ -21,8 +29,80 @@
 //   + find_sync() allows "time offsets that exceed signal boundaries" (i.e. >79 message samples)
 #define ft8_msg_samples 92  // Number of 1024 point message samples feeding the FFT?
 
+// Select the spectral front end's arithmetic:  1==all-integer (Q15 window applied with arm_mult_q15() and
+// table-driven log power), 0==the original float window and log().  The windows round differently, which flips
+// the near-zero magnitudes of quiet bins and moves their entries by up to 12 units, so the float path remains the
+// default until the integer one matches it everywhere.  Override with -D DSP_FIXED_POINT=1.
+#ifndef DSP_FIXED_POINT
+#define DSP_FIXED_POINT 0
+#endif
+
+// Select the spectrogram's storage:  1==compact 4-bit entries with a per-row base and step, small enough for
+// RAM1 (2 banks of 64 KB), 0==one byte per entry in RAM2 (2 banks of 144 KB).  Override with -D SPECTROGRAM_4BIT=1.
+#ifndef SPECTROGRAM_4BIT
+#define SPECTROGRAM_4BIT 0
+#endif
+
+// One compact spectrogram row:  the columns ft8_min_bin..ft8_buffer-1 two to a byte (even column in the low
+// nibble), each standing for base + (nibble << shift) in the one byte format's units
+#define packed_row_columns (ft8_buffer - ft8_min_bin)
+typedef struct PackedRow {
+    uint8_t base;
+    uint8_t shift;
+    uint8_t nibbles[(packed_row_columns + 1) / 2];
+} PackedRow;
+
+// Select the spectrogram's layout.  Each row holds the bins of one block (symbol period) and alt
+// (time_sub * 2 + freq_sub).  0==the original interleaved rows, ((block * 4 + alt) * num_bins + bin), so the
+// 4 alts of a block are adjacent.  1==planar, ((alt * ft8_msg_samples + block) * row_bytes + bin), so each alt's
+// blocks are contiguous for find_sync()'s scan of one alt at a time, with rows padded to whole 32 byte cache
+// lines.  Override with -D SPECTROGRAM_PLANAR=1.
+#ifndef SPECTROGRAM_PLANAR
+#define SPECTROGRAM_PLANAR 0
+#endif
+
+#if SPECTROGRAM_PLANAR
+#define spectrogram_time_rows 1                  // Rows from one block to the next
+#define spectrogram_alt_rows ft8_msg_samples     // Rows from one alt to the next
+#define spectrogram_row_bytes(num_bins) (((num_bins) + 31) & ~31)
+#else
+#define spectrogram_time_rows 4
+#define spectrogram_alt_rows 1
+#define spectrogram_row_bytes(num_bins) (num_bins)
+#endif
+
+#if SPECTROGRAM_4BIT
+#define spectrogram_size (ft8_msg_samples * 4 * sizeof(PackedRow))
+#else
+#define spectrogram_size (ft8_msg_samples * 4 * spectrogram_row_bytes(ft8_buffer))
+#endif
+
 void init_DSP(void);
 float ft_blackman_i(int i, int N);
+void extract_power(int offset);
+
+// Received audio ring (see Process_DSP.cpp)
+extern q15_t audio_ring[audio_ring_size];
+extern unsigned audio_ring_head;                 // Count of samples ingested (modulo 2^32)
+extern q15_t window_dsp_buffer[FFT_SIZE];        // Windowed FFT input
+void ingest_audio_block(const q15_t* block);     // Append one queue block of block_size samples
+void window_audio(int time_sub);                 // Window FFT_SIZE samples from the ring into window_dsp_buffer[]
+
+// The two implementations selected by DSP_FIXED_POINT, exposed for the native accuracy test
+void window_audio_float(int time_sub);
+void window_audio_q15(int time_sub);
+void log_power_float(const q15_t* magnitude, uint8_t* row, int freq_sub_stride);  // Two rows (freq_sub) from FFT_Magnitude[]
+void log_power_q15(const q15_t* magnitude, uint8_t* row, int freq_sub_stride);
+
+void pack_power_row(const uint8_t* row, PackedRow* packed);  // Compress ft8_buffer one byte entries
+extern uint8_t symbol_power[4 * ft8_buffer];                  // One byte entries of the latest symbol when SPECTROGRAM_4BIT
+
+// Double-buffered spectrogram (see Process_DSP.cpp)
+extern uint8_t* export_fft_power;          // The bank extract_power() is filling for the current timeslot
+extern unsigned spectrogram_overruns;      // Timeslots dropped as the decoder still owned its bank
+const uint8_t* handoff_spectrogram(void);  // Pass the filled bank to the decoder (NULL if it's busy)
+const uint8_t* decode_spectrogram(void);   // The bank owned by the decoder (NULL if none)
+void release_spectrogram(const uint8_t* bank);  // Decoder is finished with its bank
 
 void process_FT8_FFT(void);
 void update_offset_waterfall(int offset);
@@ -21,7 +21,7 @@ class Sequencer {
     char theirTimeslot;  // 0==even, 1==odd
 
     // The Sequencer singleton's private constructor
-    Sequencer() : state(IDLE), sequenceNumber(0), timeoutTimer(nullptr), contactLog(nullptr), lastStationMsgsItem(nullptr) {
+    Sequencer() : state(IDLE), sequenceNumber(0), workedFreq(0), timeoutTimer(nullptr), contactLog(nullptr), lastStationMsgsItem(nullptr) {
     }  // Sequencer()
 
     // Delete copy constructor and assignment operator to prevent copying
@@ -44,14 +44,17 @@ class Sequencer {
     void actionPendXmit(unsigned oddEven, SequencerStateType newState);  // Start transmitter in next timeslot
 
     // Helper methods
-    bool isMsgForUs(Decode* msg);                             // Determines if received msg is of interest to us
-    Decode* getDecodedMsg(unsigned msgIndex);                 // Retrieves pointer to new_decoded[] message
-    void startQSO(const char* workedCall, unsigned oddEven);  // Start a QSO
-    void endQSO(void);                                        // Terminate a QSO
+    bool isMsgForUs(Decode* msg);                                       // Determines if received msg is of interest to us
+    Decode* getDecodedMsg(unsigned msgIndex);                           // Retrieves pointer to a displayed decoded message
+    void startQSO(const char* workedCall, unsigned oddEven, int freq);  // Start a QSO
+    void endQSO(void);                                                  // Terminate a QSO
 
     // Private member variables
     SequencerStateType state;             // The Sequencer's current state
     unsigned long sequenceNumber;         // The current timeslot's sequence number
+    bool xmitDeferred;                    // An early decode armed the transmitter without keying it
+    unsigned long xmitDeferredSequence;   // The timeslot in which it was armed
+    int workedFreq;                       // Audio frequency (Hz) at which we heard the worked station
     Timer* timeoutTimer;                  // Terminates run-on transmissions after timeout period
     ContactLogFile* contactLog;           // The contact log file
     String lastReceivedMsg;               // The last received (decoded) message text
@@ -72,6 +75,7 @@ class Sequencer {
     void tuneButtonEvent(void);                                    // TUNE button clicked
     void clickDecodedMessageEvent(unsigned msgIndex);              // Received message clicked this index
     void clickDecodedMessageEvent(Decode* msg);                    // Received messages clicked this decoded msg
+    void keyDeferredXmit(void);                                    // Key a transmission an early decode armed, if still due
     bool inQSO(void);                                              // Determine if our station is in a QSO with any remote station
     bool inQSO(String callSign);                                   // Determine if our station is in a QSO with the specified station
 
@@ -81,6 +85,7 @@ class Sequencer {
     // Expose getters for debugging Sequencer problems
     unsigned long getSequenceNumber(void);
     SequencerStateType getState(void);
+    int getWorkedFreq(void);
 
     // Get a reference to the Sequencer singleton
     static Sequencer& getSequencer() {
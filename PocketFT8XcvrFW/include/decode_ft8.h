@@ -12,6 +12,41 @@
 #include "message.h"
 
 int ft8_decode(void);
+void ft8_decode_early(void);
+bool decoding_early(void);  // ft8_decode_early() is running and the timeslot still being received
+const int kMax_sic_passes = 3;  // Limit on config.sicPasses
+
+// What the decoder did in the last timeslot, for the per-timeslot debug report (see getDecodeStats())
+typedef struct DecodeStats {
+    // Candidates
+    int ldpc_runs_saved;      // Near-duplicate candidates the last ft8_decode() didn't LDPC decode
+    int ldpc_iterations;      // LDPC iterations the last ft8_decode() ran over all candidates
+    int candidates_skipped;   // Candidates the last ft8_decode() left undecoded at its deadline
+    int duplicates_rejected;  // Repeated decodes rejected by payload before unpacking, this timeslot
+
+    // Near misses
+    int ap_runs;          // Candidates the last ft8_decode() reran with a priori callsigns
+    int ap_decodes;       // Messages the last ft8_decode() decoded only with a priori callsigns
+    int ap_rejected;      // A priori decodes the last ft8_decode() rejected for other callsigns
+    int ap_skipped;       // A priori reruns the last ft8_decode() skipped at its deadline
+    int osd_runs;         // Near misses the last ft8_decode() passed to osd_decode()
+    int osd_decodes;      // Messages the last ft8_decode() recovered with osd_decode()
+    int osd_skipped;      // Near misses the last ft8_decode() didn't try by OSD at its deadline
+    uint32_t osd_max_us;  // Longest osd_decode() of the last ft8_decode()
+
+    // Passes
+    int early_decodes;                      // Messages the last early pass recorded (see ft8_decode_early())
+    int early_runs_saved;                   // Candidates the last ft8_decode() didn't decode as the early pass had
+    int sic_pass_decodes[kMax_sic_passes];  // Messages each pass of the last ft8_decode() recorded
+    uint32_t sic_us;                        // Time the last ft8_decode() spent subtracting signals and in its later passes
+
+    // Timing
+    int32_t decode_ms;       // When the last ft8_decode() finished, in mS after the timeslot's last symbol
+    int decode_overruns;     // Decodes that have finished after their deadline since startup
+    int32_t max_overrun_ms;  // Longest overrun of a decode's deadline since startup
+} DecodeStats;
+
+void getDecodeStats(DecodeStats* stats);
 
 static const String sp = String(" ");
 // typedef struct
@@ -35,11 +70,11 @@ class Decode {
     char field2[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE];  // Our station's call
     char field3[FTX_REPORTS_BFRSIZE];                         // Extra info
     char locator[FTX_REPORTS_BFRSIZE];                        // Their locator if we have it
-    int freq_hz;                                              //
+    int16_t freq_hz;                                          //
     char decode_time[10];                                     // Timestamp when message successfully decoded
-    int sync_score;                                           //
-    int snr;                                                  // Their received signal level
-    int distance;                                             // KM between their and our station
+    int16_t sync_score;                                       //
+    int16_t snr;                                              // Their received signal level
+    int16_t distance;                                         // KM between their and our station
     MsgType msgType;                                          // Type of received message (e.g. CQ, LOC, RSL...)
     unsigned long sequenceNumber;                             // Sequencer's timeslot sequenceNumber when msg was received
 } /*Decode*/;
@@ -60,16 +95,29 @@ typedef struct
     int freq_hz;
 } CQ_Station;
 
-Decode* getNewDecoded(void);
+// The decode arena:  ft8_decode() records each timeslot's messages in place, up to kMax_decodes of them, and the
+// display, Check_Calling_Stations() and the Sequencer iterate them there with a cursor (see firstDecoded()).
+#ifndef FT8_MAX_DECODES
+#define FT8_MAX_DECODES 64
+#endif
+const int kMax_decodes = FT8_MAX_DECODES;
+
+Decode* firstDecoded(void);
+Decode* nextDecoded(const Decode* msg);
+int decodedIndex(const Decode* msg);
+int getNumDecoded(void);
+Decode* getDisplayedDecode(int row);  // The message in a row of the Decoded Messages box
 
 void save_Answer_CQ_List(void);
 
 void display_Answer_CQ_Items(void);
 
-int Check_Calling_Stations(int num_decoded);
+int Check_Calling_Stations(void);
 void clear_CQ_List_box(void);
 // void display_details(int decoded_messages);
 void display_messages(int decoded_messages);
+int display_paging_row_index(void);  // The Decoded Messages box's paging row, or -1
+void display_next_page(void);
 void clear_display_details(void);
 int Check_CQ_Calling_Stations(int num_decoded, int reply_state);
 int Check_QSO_Calling_Stations(int num_decoded, int reply_state);
@@ -28,6 +28,7 @@ extern const int K_BYTES;
 
 extern const uint16_t CRC_POLYNOMIAL;  // CRC-14 polynomial without the leading (MSB) 1
 extern const int CRC_WIDTH;
+extern const uint16_t kCRC14_table[256];  // CRC-14 remainder of each byte value (see crc())
 
 extern uint8_t tones[79];
 
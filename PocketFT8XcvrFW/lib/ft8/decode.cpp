@@ -9,6 +9,11 @@
 #include "decode.h"
 
 #include <math.h>
+#include <string.h>
+
+#if FT8_SYNC_SIMD && defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
 
 #include "constants.h"
 
@@ -16,17 +21,17 @@
 
 #include "Process_DSP.h"
 
-// #include <HX8357_t3.h>
-#include "HX8357_t3n.h"
-extern HX8357_t3n tft;
-
 static float max2(float a, float b);
 static float max4(float a, float b, float c, float d);
 static void heapify_down(Candidate* heap, int heap_size);
 static void heapify_up(Candidate* heap, int heap_size);
 // void decode_symbol(int offset, const uint8_t *code_map, int bit_idx, float *log174);
-static void decode_symbol(const uint8_t* power, const uint8_t* code_map, int bit_idx, float* log174);
-// static void decode_multi_symbols(const uint8_t *power, int num_bins, int n_syms, const uint8_t *code_map, int bit_idx, float *log174);
+template <typename Cursor>
+static void decode_symbol(const Cursor& power, const uint8_t* code_map, int bit_idx, float* log174);
+#if FT8_LIKELIHOOD_SYMBOLS > 1
+template <typename Cursor>
+static void decode_multi_symbols(const Cursor* power, int n_syms, const uint8_t* code_map, int bit_idx, float* log174);
+#endif
 
 // extern int ND;
 // extern int NS;
@@ -41,124 +46,369 @@ static void decode_symbol(const uint8_t* power, const uint8_t* code_map, int bit
 // extern int K_BYTES;
 
 int max_score;
+#if FT8_LIKELIHOOD_SYMBOLS > 1
+int likelihood_symbols = FT8_LIKELIHOOD_SYMBOLS;
+#endif
+
+// Offer one scored (alt, time_offset, freq_offset) to the candidate min-heap
+static void offer_candidate(Candidate* heap, int* heap_size, int num_candidates, int score, int alt, int time_offset, int freq_offset) {
+    // If the heap is full AND the current candidate is better than
+    // the worst in the heap, we remove the worst and make space
+    if (*heap_size == num_candidates && score > heap[0].score) {
+        heap[0] = heap[*heap_size - 1];
+        --*heap_size;
+
+        heapify_down(heap, *heap_size);
+    }
+
+    // If there's free space in the heap, we add the current candidate
+    if (*heap_size < num_candidates) {
+        heap[*heap_size].score = score;
+        heap[*heap_size].time_offset = time_offset;
+        heap[*heap_size].freq_offset = freq_offset;
+        heap[*heap_size].time_sub = alt / 2;
+        heap[*heap_size].freq_sub = alt % 2;
+        ++*heap_size;
+
+        heapify_up(heap, *heap_size);
+    }
+}
+
+// Add n consecutive spectrogram entries to 16-bit sums:  sums[j] += row[offset + j]
+//
+// find_sync() sums at most 21 rows of entries no greater than 255, so a 16-bit lane never carries into the
+// next and the vectorized kernels may add several lanes with one ordinary add.
+#if FT8_SYNC_SIMD && defined(__ARM_FEATURE_SIMD32)
+// Cortex-M7 DSP extension:  UXTB16 spreads bytes 0,2 and 1,3 of a word into 16-bit lanes
+static void sync_accumulate(const uint8_t* row, int offset, uint16_t* sums, int n) {
+    row += offset;
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        uint32_t bytes, lo, hi;
+        memcpy(&bytes, row + j, 4);
+        memcpy(&lo, sums + j, 4);
+        memcpy(&hi, sums + j + 2, 4);
+        uint32_t even = __uxtb16(bytes);
+        uint32_t odd = __uxtb16(bytes >> 8);
+        lo += (even & 0xFFFF) | (odd << 16);
+        hi += (even >> 16) | (odd & 0xFFFF0000);
+        memcpy(sums + j, &lo, 4);
+        memcpy(sums + j + 2, &hi, 4);
+    }
+    for (; j < n; ++j) sums[j] += row[j];
+}
+#elif FT8_SYNC_SIMD
+// Portable SWAR:  4 bytes spread into the 16-bit lanes of a 64-bit word (little endian)
+static void sync_accumulate(const uint8_t* row, int offset, uint16_t* sums, int n) {
+    row += offset;
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        uint32_t bytes;
+        uint64_t lanes;
+        memcpy(&bytes, row + j, 4);
+        memcpy(&lanes, sums + j, 8);
+        uint64_t spread = bytes;
+        spread = (spread | (spread << 16)) & 0x0000FFFF0000FFFFull;
+        spread = (spread | (spread << 8)) & 0x00FF00FF00FF00FFull;
+        lanes += spread;
+        memcpy(sums + j, &lanes, 8);
+    }
+    for (; j < n; ++j) sums[j] += row[j];
+}
+#else
+static void sync_accumulate(const uint8_t* row, int offset, uint16_t* sums, int n) {
+    for (int j = 0; j < n; ++j) sums[j] += row[offset + j];
+}
+#endif
+
+// The compact spectrogram is unpacked entry by entry
+static void sync_accumulate(const PackedCursor& row, int offset, uint16_t* sums, int n) {
+    for (int j = 0; j < n; ++j) sums[j] += row[offset + j];
+}
+
+// Sum one time_offset's sync rows (m+k = 0-7, 36-43, 72-79) for every freq_offset:  columns[i] sums bin
+// ft8_min_bin+i and tones[i] sums freq_offset ft8_min_bin+i's expected tone.  Returns the number of sync
+// symbols summed.
+//
+// Here we allow time offsets that exceed signal boundaries, as long as we still have all data bits.
+// I.e. we can afford to skip the first 7 or the last 7 Costas symbols, as long as we track how many
+// sync symbols we included in the score, so the score is averaged.
+template <typename Power>
+static int sum_sync_rows(const Power& power, int num_blocks, const uint8_t* sync_map, int alt, int time_offset, int num_offsets, uint16_t* columns,
+                         uint16_t* tones) {
+    memset(columns, 0, (num_offsets + 8) * sizeof(uint16_t));
+    memset(tones, 0, num_offsets * sizeof(uint16_t));
+
+    int num_symbols = 0;
+    for (int m = 0; m <= 72; m += 36) {
+        for (int k = 0; k < 7; ++k) {
+            // Check for time boundaries
+            if (time_offset + k + m < 0) continue;
+            if (time_offset + k + m >= num_blocks) break;
+
+            const auto row = power.at(time_offset + k + m, alt, ft8_min_bin);
+            sync_accumulate(row, 0, columns, num_offsets + 8);
+            sync_accumulate(row, sync_map[k], tones, num_offsets);
+            ++num_symbols;
+        }
+    }
+    return num_symbols;
+}
+
+// Score a single cell, exactly as find_sync_in() would
+template <typename Power>
+static int sync_score(const Power& power, int num_blocks, const uint8_t* sync_map, int alt, int time_offset, int freq_offset) {
+    int score = 0;
+    int num_symbols = 0;
+    for (int m = 0; m <= 72; m += 36) {
+        for (int k = 0; k < 7; ++k) {
+            if (time_offset + k + m < 0) continue;
+            if (time_offset + k + m >= num_blocks) break;
+
+            const auto p8 = power.at(time_offset + k + m, alt, freq_offset);
+            score += 8 * p8[sync_map[k]] - p8[0] - p8[1] - p8[2] - p8[3] - p8[4] - p8[5] - p8[6] - p8[7];
+            ++num_symbols;
+        }
+    }
+    return score / num_symbols;
+}
+
+// One past the last time_offset find_sync() searches.  A candidate's last data symbol is at time_offset + 71, and
+// normally the first symbol of the Costas array after it must have arrived too; with erased_symbols, candidates
+// may lack up to that many of their last data symbols.
+static int end_time_offset(int num_blocks, int erased_symbols) {
+    if (erased_symbols > 0) return num_blocks - 71 + erased_symbols;
+    return num_blocks - NN + 7;  // NN=79
+}
 
 // Localize top N candidates in frequency and time according to their sync strength (looking at Costas symbols)
 // We treat and organize the candidate list as a min-heap (empty initially).
-int find_sync(const uint8_t* power, int num_blocks, int num_bins, const uint8_t* sync_map, int num_candidates, Candidate* heap, int min_score) {
+//
+// The spectrogram is read through an accessor (PowerBytes or PowerNibbles) so either storage format may be searched.
+//
+// Each sync symbol contributes 8 * p8[sync_map[k]] - (p8[0] + ... + p8[7]) to a candidate's score.  Summed over
+// the sync symbols, that's 8 times the sum of the expected tones less the 8 bin window sum of the rows' column
+// sums.  So rather than visit 9 bins per cell, find_sync() accumulates both sums for all freq_offsets at one
+// time_offset with vectorizable passes along each sync row (see sync_accumulate()), then slides the 8 bin window
+// along the column sums once.  Candidates are offered to the heap in the original (alt, time_offset,
+// freq_offset) order so the result is identical to scoring each cell separately.
+template <typename Power>
+static int find_sync_in(const Power& power, int num_blocks, int num_bins, const uint8_t* sync_map, int num_candidates, Candidate* heap, int min_score,
+                        int erased_symbols) {
     // DPRINTF("num_blocks=%d, num_bins=%d, num_candidates=%d, min_score=%d\n", num_blocks,num_bins,num_candidates,min_score);
     int heap_size = 0;
     max_score = 0;
-    // int x = 500;
-    // Here we allow time offsets that exceed signal boundaries, as long as we still have all data bits.
-    // I.e. we can afford to skip the first 7 or the last 7 Costas symbols, as long as we track how many
-    // sync symbols we included in the score, so the score is averaged.
+    const int num_offsets = num_bins - 8 - ft8_min_bin;  // freq_offsets ft8_min_bin..num_bins-9
+    if (num_offsets <= 0 || num_bins > ft8_buffer) return 0;
+    uint16_t columns[ft8_buffer] __attribute__((aligned(8)));  // Sum over the sync rows of each bin
+    uint16_t tones[ft8_buffer] __attribute__((aligned(8)));    // Sum over the sync rows of each freq_offset's expected tone
+
     for (int alt = 0; alt < 4; ++alt) {
-        // int alt = 0;
-        for (int time_offset = -7; time_offset < num_blocks - NN + 7; ++time_offset) {  // NN=79
-            for (int freq_offset = ft8_min_bin; freq_offset < num_bins - 8; ++freq_offset) {
-                int score = 0;
-
-                // Compute average score over sync symbols (m+k = 0-7, 36-43, 72-79)
-                int num_symbols = 0;
-                for (int m = 0; m <= 72; m += 36) {
-                    for (int k = 0; k < 7; ++k) {
-                        // Check for time boundaries
-                        if (time_offset + k + m < 0) continue;
-                        if (time_offset + k + m >= num_blocks) break;
-
-                        int offset = ((time_offset + k + m) * 4 + alt) * num_bins + freq_offset;
-
-                        const uint8_t* p8 = power + offset;
-
-                        score += 8 * p8[sync_map[k]] - p8[0] - p8[1] - p8[2] - p8[3] - p8[4] - p8[5] - p8[6] - p8[7];
-
-                        /*
-                                    // Check only the neighbors of the expected symbol frequency- and time-wise
-                                    int sm = sync_map[k];   // Index of the expected bin
-                                    if (sm > 0) {
-                                        // look at one frequency bin lower
-                                        score += p8[sm] - p8[sm - 1];
-                                    }
-                                    if (sm < 7) {
-                                        // look at one frequency bin higher
-                                        score += p8[sm] - p8[sm + 1];
-                                    }
-                                    if (k > 0) {
-                                        // look one symbol back in time
-                                        score += p8[sm] - p8[sm - 4 * num_bins];
-                                    }
-                                    if (k < 6) {
-                                        // look one symbol forward in time
-                                        score += p8[sm] - p8[sm + 4 * num_bins];
-                                    }
-                                    */
-
-                        ++num_symbols;
-                    }
-                }
-                score /= num_symbols;
+        for (int time_offset = -7; time_offset < end_time_offset(num_blocks, erased_symbols); ++time_offset) {
+            int num_symbols = sum_sync_rows(power, num_blocks, sync_map, alt, time_offset, num_offsets, columns, tones);
+
+            int window = columns[0] + columns[1] + columns[2] + columns[3] + columns[4] + columns[5] + columns[6] + columns[7];
+            for (int i = 0; i < num_offsets; ++i) {
+                int score = (8 * tones[i] - window) / num_symbols;
+                window += columns[i + 8] - columns[i];
 
                 if (score > max_score) max_score = score;  // Can comment-out this line
                 if (score < min_score) continue;
 
-                // If the heap is full AND the current candidate is better than
-                // the worst in the heap, we remove the worst and make space
-                if (heap_size == num_candidates && score > heap[0].score) {
-                    heap[0] = heap[heap_size - 1];
-                    --heap_size;
+                offer_candidate(heap, &heap_size, num_candidates, score, alt, time_offset, ft8_min_bin + i);
+            }
+        }
+
+    }  // end of alt
 
-                    heapify_down(heap, heap_size);
-                }
+    // DPRINTF("max_score=%d\n",max_score);
+    return heap_size;
+}
+
+// The coarse pass keeps this many peaks per candidate requested, at most kMax_coarse_peaks
+static const int kCoarse_peaks_per_candidate = 2;
+static const int kMax_coarse_peaks = 64;
+
+// Coarse-to-fine alternative to find_sync_in()
+//
+// The coarse pass scores only alt 0 (time_sub = freq_sub = 0) at every other time_offset and every other
+// freq_offset, one eighth of the cells, keeping the best peaks that reach half of min_score (a signal
+// between grid points scores lower there).  The fine pass then scores each peak's neighbourhood, +/-1
+// time_offset and freq_offset in all four alts, cell by cell and offers those cells to the heap.
+template <typename Power>
+static int find_sync_coarse_in(const Power& power, int num_blocks, int num_bins, const uint8_t* sync_map, int num_candidates, Candidate* heap,
+                               int min_score, int erased_symbols) {
+    int heap_size = 0;
+    max_score = 0;
+    const int num_offsets = num_bins - 8 - ft8_min_bin;
+    if (num_offsets <= 0 || num_bins > ft8_buffer) return 0;
+    uint16_t columns[ft8_buffer] __attribute__((aligned(8)));
+    uint16_t tones[ft8_buffer] __attribute__((aligned(8)));
+
+    Candidate peaks[kMax_coarse_peaks];
+    int num_peaks = 0;
+    int max_peaks = num_candidates * kCoarse_peaks_per_candidate;
+    if (max_peaks > kMax_coarse_peaks) max_peaks = kMax_coarse_peaks;
+
+    const int end_offset = end_time_offset(num_blocks, erased_symbols);
+    for (int time_offset = -7; time_offset < end_offset; time_offset += 2) {
+        int num_symbols = sum_sync_rows(power, num_blocks, sync_map, 0, time_offset, num_offsets, columns, tones);
+
+        for (int i = 0; i < num_offsets; i += 2) {
+            int window = 0;
+            for (int j = 0; j < 8; ++j) window += columns[i + j];
+            int score = (8 * tones[i] - window) / num_symbols;
 
-                // If there's free space in the heap, we add the current candidate
-                if (heap_size < num_candidates) {
-                    heap[heap_size].score = score;
-                    heap[heap_size].time_offset = time_offset;
-                    heap[heap_size].freq_offset = freq_offset;
-                    heap[heap_size].time_sub = alt / 2;
-                    heap[heap_size].freq_sub = alt % 2;
-                    ++heap_size;
+            if (score > max_score) max_score = score;
+            if (score < min_score / 2) continue;
 
-                    heapify_up(heap, heap_size);
+            offer_candidate(peaks, &num_peaks, max_peaks, score, 0, time_offset, ft8_min_bin + i);
+        }
+    }
+
+    for (int p = 0; p < num_peaks; ++p) {
+        for (int alt = 0; alt < 4; ++alt) {
+            for (int time_offset = peaks[p].time_offset - 1; time_offset <= peaks[p].time_offset + 1; ++time_offset) {
+                if (time_offset < -7 || time_offset >= end_offset) continue;
+                for (int freq_offset = peaks[p].freq_offset - 1; freq_offset <= peaks[p].freq_offset + 1; ++freq_offset) {
+                    if (freq_offset < ft8_min_bin || freq_offset >= num_bins - 8) continue;
+
+                    // Neighbourhoods of adjacent peaks overlap
+                    bool seen = false;
+                    for (int c = 0; c < heap_size && !seen; ++c) {
+                        seen = heap[c].time_offset == time_offset && heap[c].freq_offset == freq_offset && heap[c].time_sub == alt / 2 &&
+                               heap[c].freq_sub == alt % 2;
+                    }
+                    if (seen) continue;
+
+                    int score = sync_score(power, num_blocks, sync_map, alt, time_offset, freq_offset);
+                    if (score > max_score) max_score = score;
+                    if (score < min_score) continue;
+
+                    offer_candidate(heap, &heap_size, num_candidates, score, alt, time_offset, freq_offset);
                 }
             }
         }
+    }
 
-    }  // end of alt
-
-    // DPRINTF("max_score=%d\n",max_score);
     return heap_size;
 }
 
+template <typename Power>
+static int find_sync_using(SyncSearch search, const Power& power, int num_blocks, int num_bins, const uint8_t* sync_map, int num_candidates,
+                           Candidate* heap, int min_score, int erased_symbols) {
+    if (erased_symbols < 0) erased_symbols = 0;
+    if (erased_symbols > kMax_erased_symbols) erased_symbols = kMax_erased_symbols;
+    if (search == kSync_coarse_to_fine) return find_sync_coarse_in(power, num_blocks, num_bins, sync_map, num_candidates, heap, min_score, erased_symbols);
+    return find_sync_in(power, num_blocks, num_bins, sync_map, num_candidates, heap, min_score, erased_symbols);
+}
+
+// The spectrogram layout selected by SPECTROGRAM_PLANAR
+static PowerBytes spectrogram_bytes(const uint8_t* power, int num_bins) {
+    int row_bytes = spectrogram_row_bytes(num_bins);
+    PowerBytes bytes = {power, spectrogram_time_rows * row_bytes, spectrogram_alt_rows * row_bytes};
+    return bytes;
+}
+
+int find_sync(const uint8_t* power, int num_blocks, int num_bins, const uint8_t* sync_map, int num_candidates, Candidate* heap, int min_score,
+              SyncSearch search, int erased_symbols) {
+    return find_sync_using(search, spectrogram_bytes(power, num_bins), num_blocks, num_bins, sync_map, num_candidates, heap, min_score, erased_symbols);
+}
+
+int find_sync(const PowerBytes& power, int num_blocks, int num_bins, const uint8_t* sync_map, int num_candidates, Candidate* heap, int min_score,
+              SyncSearch search, int erased_symbols) {
+    return find_sync_using(search, power, num_blocks, num_bins, sync_map, num_candidates, heap, min_score, erased_symbols);
+}
+
+int find_sync(const PackedRow* power, int num_blocks, int num_bins, const uint8_t* sync_map, int num_candidates, Candidate* heap, int min_score,
+              SyncSearch search, int erased_symbols) {
+    PowerNibbles nibbles = {power};
+    return find_sync_using(search, nibbles, num_blocks, num_bins, sync_map, num_candidates, heap, min_score, erased_symbols);
+}
+
+int suppress_candidates(Candidate* candidates, int num_candidates, int max_kept, int* runs_saved) {
+    // Insertion sort by descending score (the heap holds a few dozen)
+    for (int i = 1; i < num_candidates; ++i) {
+        Candidate c = candidates[i];
+        int j = i;
+        for (; j > 0 && candidates[j - 1].score < c.score; --j) candidates[j] = candidates[j - 1];
+        candidates[j] = c;
+    }
+
+    // Keep each candidate unless a stronger one lies within +/-1 step, measured in sub-offsets (half steps)
+    int num_kept = 0;
+    *runs_saved = 0;
+    for (int i = 0; i < num_candidates && num_kept < max_kept; ++i) {
+        int t = 2 * candidates[i].time_offset + candidates[i].time_sub;
+        int f = 2 * candidates[i].freq_offset + candidates[i].freq_sub;
+        bool duplicate = false;
+        for (int k = 0; k < num_kept && !duplicate; ++k) {
+            int dt = t - (2 * candidates[k].time_offset + candidates[k].time_sub);
+            int df = f - (2 * candidates[k].freq_offset + candidates[k].freq_sub);
+            duplicate = dt >= -2 && dt <= 2 && df >= -2 && df <= 2;
+        }
+        if (duplicate) {
+            if (i < max_kept) ++*runs_saved;
+            continue;
+        }
+        candidates[num_kept++] = candidates[i];
+    }
+    return num_kept;
+}
+
 // Compute log likelihood log(p(1) / p(0)) of 174 message bits
 // for later use in soft-decision LDPC decoding
-void extract_likelihood(const uint8_t* power, int num_bins, Candidate cand, const uint8_t* code_map, float* log174) {
-    int ft8_offset = (cand.time_offset * 4 + cand.time_sub * 2 + cand.freq_sub) * num_bins + cand.freq_offset;
+template <typename Power>
+static void extract_likelihood_in(const Power& power, int num_blocks, Candidate cand, const uint8_t* code_map, float* log174) {
+    int alt = cand.time_sub * 2 + cand.freq_sub;
     // tft.graphicsMode();
     // tft.drawLine(cand.freq_offset, 479,cand.freq_offset,479-100 , RA8875_YELLOW);
     // tft.drawLine(0, 0,1,1 , RA8875_YELLOW);
     // display_value(500,20,ft8_offset);
 
     // show_variable(600,200,offset);
-    //  Go over FSK tones and skip Costas sync symbols
+    //  Go over FSK tones and skip Costas sync symbols, likelihood_symbols at a time within each half
+#if FT8_LIKELIHOOD_SYMBOLS > 1
+    const int n_syms = likelihood_symbols;
+#else
     const int n_syms = 1;
-    // const int n_bits = 3 * n_syms;
-    // const int n_tones = (1 << n_bits);
-    for (int k = 0; k < ND; k += n_syms) {
+#endif
+    int num_erased = 0;  // Trailing bits of the symbols not yet received
+    for (int k = 0; k < ND;) {
         int sym_idx = (k < ND / 2) ? (k + 7) : (k + 14);
         int bit_idx = 3 * k;
+        int half_end = (k < ND / 2) ? ND / 2 : ND;
+        int group = (k + n_syms <= half_end) ? n_syms : half_end - k;
+
+        // Symbols not yet received are erasures, their bits neither 1 nor 0, and a group ends at the last one received
+        int received = num_blocks - (cand.time_offset + sym_idx);
+        if (received <= 0) {
+            for (int i = bit_idx; i < N; ++i) log174[i] = 0;
+            num_erased = N - bit_idx;
+            break;
+        }
+        if (group > received) group = received;
 
-        // Pointer to 8 bins of the current symbol
-        const uint8_t* ps = power + (ft8_offset + sym_idx * 4 * num_bins);
-
-        decode_symbol(ps, code_map, bit_idx, log174);
+        // Cursor to 8 bins of the current symbol
+        if (group <= 1) {
+            const auto ps = power.at(cand.time_offset + sym_idx, alt, cand.freq_offset);
+            decode_symbol(ps, code_map, bit_idx, log174);
+        }
+#if FT8_LIKELIHOOD_SYMBOLS > 1
+        else {
+            decltype(power.at(0, 0, 0)) ps[3];
+            for (int s = 0; s < group; ++s) ps[s] = power.at(cand.time_offset + sym_idx + s, alt, cand.freq_offset);
+            decode_multi_symbols(ps, group, code_map, bit_idx, log174);
+        }
+#endif
+        k += (group > 1) ? group : 1;
     }
 
-    // Compute the variance of log174
+    // Compute the variance of the received bits' log174
     float sum = 0;
     float sum2 = 0;
-    float inv_n = 1.0f / N;
-    for (int i = 0; i < N; ++i) {
+    float inv_n = 1.0f / (N - num_erased);
+    for (int i = 0; i < N - num_erased; ++i) {
         sum += log174[i];
         sum2 += log174[i] * log174[i];
     }
@@ -171,6 +421,195 @@ void extract_likelihood(const uint8_t* power, int num_bins, Candidate cand, cons
     }
 }
 
+void extract_likelihood(const uint8_t* power, int num_bins, Candidate cand, const uint8_t* code_map, float* log174, int num_blocks) {
+    extract_likelihood_in(spectrogram_bytes(power, num_bins), num_blocks, cand, code_map, log174);
+}
+
+// The view and the compact rows carry their own layout, so num_bins goes unused
+void extract_likelihood(const PowerBytes& power, int /* num_bins */, Candidate cand, const uint8_t* code_map, float* log174, int num_blocks) {
+    extract_likelihood_in(power, num_blocks, cand, code_map, log174);
+}
+
+void extract_likelihood(const PackedRow* power, int /* num_bins */, Candidate cand, const uint8_t* code_map, float* log174, int num_blocks) {
+    PowerNibbles nibbles = {power};
+    extract_likelihood_in(nibbles, num_blocks, cand, code_map, log174);
+}
+
+void apply_apriori_callsigns(float* log174, const uint8_t* a77) {
+    float magnitude = 0;
+    for (int i = 0; i < N; ++i) magnitude = max2(magnitude, fabsf(log174[i]));
+    magnitude *= 1.01f;
+
+    for (int i = 0; i < 77; ++i) {
+        if (i == kAP_callsign_bits) i = 74;  // Skip the report/grid bits to i3
+        bool one = (a77[i >> 3] >> (7 - (i & 7))) & 1;
+        log174[i] = one ? magnitude : -magnitude;
+    }
+}
+
+void payload_set_clear(PayloadSet& set) {
+    memset(set.used, 0, sizeof(set.used));
+    set.count = 0;
+}
+
+bool payload_set_insert(PayloadSet& set, const uint8_t* a91) {
+    uint32_t key[3];
+    for (int w = 0; w < 3; ++w) {
+        key[w] = ((uint32_t)a91[4 * w] << 24) | ((uint32_t)a91[4 * w + 1] << 16) | ((uint32_t)a91[4 * w + 2] << 8) | a91[4 * w + 3];
+    }
+
+    // Payloads are well mixed already, but a91[9..11] are mostly the cleared CRC
+    uint32_t hash = (key[0] * 0x9E3779B1u) ^ (key[1] * 0x85EBCA77u) ^ (key[2] * 0xC2B2AE3Du);
+    int i = hash >> 25;  // Top 7 bits of kPayload_set_slots
+    for (; set.used[i]; i = (i + 1) & (kPayload_set_slots - 1)) {
+        if (set.key[i][0] == key[0] && set.key[i][1] == key[1] && set.key[i][2] == key[2]) return false;
+    }
+    if (set.count >= kPayload_set_limit) return false;
+
+    memcpy(set.key[i], key, sizeof(key));
+    set.used[i] = 1;
+    set.count++;
+    return true;
+}
+
+// Linear power of each spectrogram entry, whose units are 5 ln(power) (see log_power_float())
+static float entry_power[256];
+static bool entry_power_ready = false;
+
+static void init_entry_power(void) {
+    for (int u = 0; u < 256; ++u) entry_power[u] = expf(u / 5.0f);
+    entry_power_ready = true;
+}
+
+static int power_entry(float power) {
+    int u = (int)(5.0f * logf(power) + 0.5f);
+    return (u < 0) ? 0 : ((u > 255) ? 255 : u);
+}
+
+// Writable spectrogram entries for subtract_signal(), in the one byte format's units
+struct EntryBytes {
+    uint8_t* power;
+    int time_stride;
+    int alt_stride;
+    int get(int block, int alt, int bin) const { return power[block * time_stride + alt * alt_stride + bin]; }
+    void set(int block, int alt, int bin, int entry) { power[block * time_stride + alt * alt_stride + bin] = entry; }
+};
+
+// A compact row's entries are requantized to its base and step
+struct EntryNibbles {
+    PackedRow* rows;
+    PackedRow* row(int block, int alt) const { return rows + block * spectrogram_time_rows + alt * spectrogram_alt_rows; }
+    int get(int block, int alt, int bin) const {
+        PackedCursor cursor = {row(block, alt), bin - ft8_min_bin};
+        return cursor[0];
+    }
+    void set(int block, int alt, int bin, int entry) {
+        PackedRow* r = row(block, alt);
+        int c = bin - ft8_min_bin;
+        int nibble = (entry - r->base + ((1 << r->shift) >> 1)) >> r->shift;
+        nibble = (nibble < 0) ? 0 : ((nibble > 15) ? 15 : nibble);
+        int shift = (c & 1) << 2;
+        r->nibbles[c >> 1] = (uint8_t)((r->nibbles[c >> 1] & ~(0x0F << shift)) | (nibble << shift));
+    }
+};
+
+// Median of n values, which are reordered
+static float median(float* values, int n) {
+    for (int i = 1; i < n; ++i) {
+        float v = values[i];
+        int j = i;
+        for (; j > 0 && values[j - 1] > v; --j) values[j] = values[j - 1];
+        values[j] = v;
+    }
+    return values[n / 2];
+}
+
+// Rounded down half of a (possibly negative) number of half steps
+static int floor_half(int half_steps) {
+    return (half_steps - (half_steps & 1)) / 2;
+}
+
+// The window's and symbols' spreading of a tone:  the blocks and bins around it whose power subtract_signal() profiles
+const int kSpread_first_block = -1;
+const int kSpread_blocks = 3;
+const int kSpread_first_bin = -1;
+const int kSpread_bins = 4;
+
+template <typename Entries>
+static void subtract_signal_in(Entries& power, int num_blocks, int num_bins, Candidate cand, const uint8_t* tones) {
+    if (!entry_power_ready) init_entry_power();
+    int cand_alt = cand.time_sub * 2 + cand.freq_sub;
+
+    // Where the candidate is aligned, each symbol's noise is the mean of the tones away from the transmitted one
+    float noise[79];  // [NN]
+    for (int k = 0; k < NN; ++k) {
+        int block = cand.time_offset + k;
+        noise[k] = 0;
+        if (block < 0 || block >= num_blocks) continue;
+        float sum = 0;
+        int count = 0;
+        for (int t = 0; t < 8; ++t) {
+            if (t >= tones[k] - 1 && t <= tones[k] + 1) continue;
+            sum += entry_power[power.get(block, cand_alt, cand.freq_offset + t)];
+            ++count;
+        }
+        noise[k] = sum / count;
+    }
+
+    for (int alt = 0; alt < 4; ++alt) {
+        // Where this alt sees each symbol's tone, rounded down to whole blocks and bins
+        int time_half_steps = 2 * cand.time_offset + cand.time_sub - alt / 2;
+        int freq_half_steps = 2 * cand.freq_offset + cand.freq_sub - alt % 2;
+
+        // The signal's power in each entry around its tone is the median over the symbols of that entry's excess over
+        // the symbol's noise, so symbols that collide with other signals don't inflate the estimate
+        float profile[kSpread_blocks][kSpread_bins];
+        for (int db = 0; db < kSpread_blocks; ++db) {
+            for (int df = 0; df < kSpread_bins; ++df) {
+                float excess[79];  // [NN]
+                int num_excess = 0;
+                for (int k = 0; k < NN; ++k) {
+                    int block = floor_half(time_half_steps) + k + kSpread_first_block + db;
+                    int bin = floor_half(freq_half_steps + 2 * tones[k]) + kSpread_first_bin + df;
+                    if (noise[k] == 0 || block < 0 || block >= num_blocks || bin < ft8_min_bin || bin >= num_bins) continue;
+                    excess[num_excess++] = entry_power[power.get(block, alt, bin)] - noise[k];
+                }
+                profile[db][df] = (num_excess > 0) ? median(excess, num_excess) : 0;
+            }
+        }
+
+        // Subtract the profile from the entries above their symbol's noise.  An entry the signal explains to within
+        // 3 dB is left at the noise, as the profile's error would otherwise remain far above it for a strong signal.
+        for (int k = 0; k < NN; ++k) {
+            if (noise[k] == 0) continue;
+            for (int db = 0; db < kSpread_blocks; ++db) {
+                int block = floor_half(time_half_steps) + k + kSpread_first_block + db;
+                if (block < 0 || block >= num_blocks) continue;
+                for (int df = 0; df < kSpread_bins; ++df) {
+                    int bin = floor_half(freq_half_steps + 2 * tones[k]) + kSpread_first_bin + df;
+                    if (profile[db][df] <= 0 || bin < ft8_min_bin || bin >= num_bins) continue;
+                    float entry = entry_power[power.get(block, alt, bin)];
+                    if (entry <= noise[k]) continue;
+                    float remaining = entry - profile[db][df];
+                    if (remaining < profile[db][df] + noise[k]) remaining = noise[k];
+                    power.set(block, alt, bin, power_entry(remaining));
+                }
+            }
+        }
+    }
+}
+
+void subtract_signal(uint8_t* power, int num_blocks, int num_bins, Candidate cand, const uint8_t* tones) {
+    int row_bytes = spectrogram_row_bytes(num_bins);
+    EntryBytes entries = {power, spectrogram_time_rows * row_bytes, spectrogram_alt_rows * row_bytes};
+    subtract_signal_in(entries, num_blocks, num_bins, cand, tones);
+}
+
+void subtract_signal(PackedRow* power, int num_blocks, int num_bins, Candidate cand, const uint8_t* tones) {
+    EntryNibbles entries = {power};
+    subtract_signal_in(entries, num_blocks, num_bins, cand, tones);
+}
+
 static float max2(float a, float b) {
     return (a >= b) ? a : b;
 }
@@ -221,7 +660,8 @@ static void heapify_up(Candidate* heap, int heap_size) {
 }
 
 // Compute unnormalized log likelihood log(p(1) / p(0)) of 3 message bits (1 FSK symbol)
-static void decode_symbol(const uint8_t* power, const uint8_t* code_map, int bit_idx, float* log174) {
+template <typename Cursor>
+static void decode_symbol(const Cursor& power, const uint8_t* code_map, int bit_idx, float* log174) {
     // Cleaned up code for the simple case of n_syms==1
     float s2[8];
 
@@ -235,60 +675,54 @@ static void decode_symbol(const uint8_t* power, const uint8_t* code_map, int bit
     log174[bit_idx + 2] = max4(s2[1], s2[3], s2[5], s2[7]) - max4(s2[0], s2[2], s2[4], s2[6]);
 }
 
-// // Compute unnormalized log likelihood log(p(1) / p(0)) of bits corresponding to several FSK symbols at once
-// static void decode_multi_symbols(const uint8_t *power, int num_bins, int n_syms, const uint8_t *code_map, int bit_idx, float *log174) {
-//   // The following section implements what seems to be multiple-symbol decode at one go,
-//   // corresponding to WSJT-X's ft8b.f90. Experimentally found not to be any better than
-//   // 1-symbol decode.
-
-//   const int n_bits = 3 * n_syms;
-//   const int n_tones = (1 << n_bits);
-
-//   float s2[n_tones];
-
-//   for (int j = 0; j < n_tones; ++j) {
-//     int j1 = j & 0x07;
-//     if (n_syms == 1) {
-//       s2[j] = (float)power[code_map[j1]];
-//       continue;
-//     }
-//     int j2 = (j >> 3) & 0x07;
-//     if (n_syms == 2) {
-//       s2[j] = (float)power[code_map[j2]];
-//       s2[j] += (float)power[code_map[j1] + 4 * num_bins];
-//       continue;
-//     }
-//     int j3 = (j >> 6) & 0x07;
-//     s2[j] = (float)power[code_map[j3]];
-//     s2[j] += (float)power[code_map[j2] + 4 * num_bins];
-//     s2[j] += (float)power[code_map[j1] + 8 * num_bins];
-//   }
-//   // No need to go back to linear scale any more. Works better in dB.
-//   // for (int j = 0; j < n_tones; ++j) {
-//   //     s2[j] = powf(10.0f, 0.1f * s2[j]);
-//   // }
-
-//   uint16_t mask;  //chh
-
-//   // Extract bit significance (and convert them to float)
-//   // 8 FSK tones = 3 bits
-//   for (int i = 0; i < n_bits; ++i) {
-
-//     if (bit_idx + i >= N) {
-//       // Respect array size
-//       break;
-//     }
-
-//     mask = (n_tones >> (i + 1));
-//     float max_zero = -1000, max_one = -1000;
-//     for (int n = 0; n < n_tones; ++n) {
-//       if (n & mask) {
-//         max_one = max2(max_one, s2[n]);
-//       } else {
-//         max_zero = max2(max_zero, s2[n]);
-//       }
-//     }
-
-//     log174[bit_idx + i] = max_one - max_zero;
-//   }
-// }
+#if FT8_LIKELIHOOD_SYMBOLS > 1
+// decode_multi_symbols()'s tone combination tables:  combo_ones2[i] (2 symbols) and combo_ones3[i] (3 symbols)
+// list the combinations, as indices into s2[], in which bit i (0 the first symbol's MSB) is set.  Clearing the
+// bit in each gives those in which it's clear.
+static uint16_t combo_ones2[6][32];
+static uint16_t combo_ones3[9][256];
+static bool combos_ready;
+
+static void init_combos(void) {
+    for (int i = 0; i < 9; ++i) {
+        int count2 = 0, count3 = 0;
+        for (int j = 0; j < 512; ++j) {
+            if (i < 6 && j < 64 && (j & (64 >> (i + 1)))) combo_ones2[i][count2++] = j;
+            if (j & (512 >> (i + 1))) combo_ones3[i][count3++] = j;
+        }
+    }
+    combos_ready = true;
+}
+
+// Compute unnormalized log likelihood log(p(1) / p(0)) of the 3 * n_syms bits of n_syms (2 or 3) consecutive
+// FSK symbols at once, corresponding to WSJT-X's ft8b.f90.  power[s] is the cursor to symbol s's 8 bins.
+template <typename Cursor>
+static void decode_multi_symbols(const Cursor* power, int n_syms, const uint8_t* code_map, int bit_idx, float* log174) {
+    if (!combos_ready) init_combos();
+
+    // Each symbol's tones in Gray code order, then the sum over the symbols of every combination
+    float tones[3][8];
+    for (int s = 0; s < n_syms; ++s) {
+        for (int j = 0; j < 8; ++j) tones[s][j] = (float)power[s][code_map[j]];
+    }
+    float s2[512];
+    const int n_bits = 3 * n_syms;
+    const int n_tones = 1 << n_bits;
+    if (n_syms == 2) {
+        for (int j = 0; j < 64; ++j) s2[j] = tones[0][j >> 3] + tones[1][j & 7];
+    } else {
+        for (int j = 0; j < 512; ++j) s2[j] = tones[0][j >> 6] + tones[1][(j >> 3) & 7] + tones[2][j & 7];
+    }
+
+    for (int i = 0; i < n_bits; ++i) {
+        const int mask = n_tones >> (i + 1);
+        const uint16_t* ones = (n_syms == 2) ? combo_ones2[i] : combo_ones3[i];
+        float max_zero = -1000, max_one = -1000;
+        for (int c = 0; c < n_tones / 2; ++c) {
+            max_one = max2(max_one, s2[ones[c]]);
+            max_zero = max2(max_zero, s2[ones[c] ^ mask]);
+        }
+        log174[bit_idx + i] = max_one - max_zero;
+    }
+}
+#endif  // FT8_LIKELIHOOD_SYMBOLS > 1
@@ -10,6 +10,14 @@
 
 #include <stdint.h>
 
+#include "Process_DSP.h"
+
+// Select find_sync()'s kernel for summing spectrogram rows:  1==vectorized (the Cortex-M7's DSP extension
+// where available, otherwise portable 64-bit SWAR), 0==scalar.  Override with -D FT8_SYNC_SIMD=0.
+#ifndef FT8_SYNC_SIMD
+#define FT8_SYNC_SIMD 1
+#endif
+
 typedef struct Candidate {
   int16_t score;
   int16_t time_offset;
@@ -23,16 +31,112 @@ typedef struct Candidate {
 
 
 
+// Spectrogram accessors for find_sync() and extract_likelihood().  at(block, alt, bin) returns a cursor
+// to that entry, which may be indexed by the following bins of the same row.
+
+// One byte per entry, indexed (block * time_stride + alt * alt_stride + bin) (see SPECTROGRAM_PLANAR)
+struct PowerBytes {
+  const uint8_t *power;
+  int time_stride;
+  int alt_stride;
+  const uint8_t *at(int block, int alt, int bin) const { return power + block * time_stride + alt * alt_stride + bin; }
+};
+
+// Compact rows (see PackedRow), unpacked on the fly
+struct PackedCursor {
+  const PackedRow *row;
+  int column;
+  int operator[](int i) const {
+    int c = column + i;
+    return row->base + (((row->nibbles[c >> 1] >> ((c & 1) << 2)) & 0x0F) << row->shift);
+  }
+};
+
+struct PowerNibbles {
+  const PackedRow *rows;
+  PackedCursor at(int block, int alt, int bin) const {
+    PackedCursor cursor = {rows + block * spectrogram_time_rows + alt * spectrogram_alt_rows, bin - ft8_min_bin};
+    return cursor;
+  }
+};
+
+// Trailing data symbols an early pass may decode without:  find_sync() given erased_symbols (at most
+// kMax_erased_symbols) also finds candidates lacking up to that many of their last data symbols, and
+// extract_likelihood() given num_blocks gives those symbols' bits zero likelihood for the LDPC decoder to
+// recover, as WSJT-X's decode at 11.8 S does.  By 74 symbols, three reach signals that began up to 0.8 S in.
+const int kMax_erased_symbols = 3;
+
+// find_sync()'s search strategies
+enum SyncSearch {
+  kSync_exhaustive = 0,     // Score every alt, time_offset and freq_offset
+  kSync_coarse_to_fine = 1  // Score alt 0 on every other time_offset and freq_offset, then refine the best peaks
+};
+
 // Localize top N candidates in frequency and time according to their sync strength (looking at Costas symbols)
 // We treat and organize the candidate list as a min-heap (empty initially).
-int find_sync(const uint8_t *power, int num_blocks, int num_bins, const uint8_t *sync_map, int num_candidates, Candidate *heap, int min_score);
-
+//
+// The uint8_t and PackedRow spectrograms are in the layout selected by SPECTROGRAM_PLANAR; a PowerBytes
+// may describe any other.
+int find_sync(const uint8_t *power, int num_blocks, int num_bins, const uint8_t *sync_map, int num_candidates, Candidate *heap, int min_score,
+              SyncSearch search = kSync_exhaustive, int erased_symbols = 0);
+int find_sync(const PackedRow *power, int num_blocks, int num_bins, const uint8_t *sync_map, int num_candidates, Candidate *heap, int min_score,
+              SyncSearch search = kSync_exhaustive, int erased_symbols = 0);
+int find_sync(const PowerBytes &power, int num_blocks, int num_bins, const uint8_t *sync_map, int num_candidates, Candidate *heap, int min_score,
+              SyncSearch search = kSync_exhaustive, int erased_symbols = 0);
+
+// Merge near-duplicate candidates before any LDPC work:  sort by descending score and drop each candidate within
+// one time step and one frequency bin (counting time_sub and freq_sub) of a stronger one.  Keeps at most max_kept.
+// Returns the number kept; *runs_saved receives how many of the num_candidates' top max_kept were dropped, i.e.
+// the LDPC runs a decoder taking the top max_kept no longer spends on duplicates.
+int suppress_candidates(Candidate *candidates, int num_candidates, int max_kept, int *runs_saved);
 
 // Compute log likelihood log(p(1) / p(0)) of 174 message bits
-// for later use in soft-decision LDPC decoding
-//chhvoid extract_likelihood(const uint8_t *power, int num_bins, const Candidate & cand, const uint8_t *code_map, float *log174);
-
-void extract_likelihood(const uint8_t *power, int num_bins, Candidate cand, const uint8_t *code_map, float *log174);
+// for later use in soft-decision LDPC decoding.  Symbols from block num_blocks on haven't been received and are erased.
+void extract_likelihood(const uint8_t *power, int num_bins, Candidate cand, const uint8_t *code_map, float *log174,
+                        int num_blocks = ft8_msg_samples);
+void extract_likelihood(const PackedRow *power, int num_bins, Candidate cand, const uint8_t *code_map, float *log174,
+                        int num_blocks = ft8_msg_samples);
+void extract_likelihood(const PowerBytes &power, int num_bins, Candidate cand, const uint8_t *code_map, float *log174,
+                        int num_blocks = ft8_msg_samples);
+
+// Data symbols extract_likelihood() demodulates together (1, 2 or 3, as n_syms in WSJT-X's ft8b.f90):  each bit's
+// likelihood is taken over every tone combination of the group rather than over its own symbol's 8 tones.
+// On this power-only spectrogram the group likelihoods equal the single-symbol ones (test_multi_symbol), so
+// the multi-symbol path is built only with -D FT8_LIKELIHOOD_SYMBOLS=2 or 3.
+#ifndef FT8_LIKELIHOOD_SYMBOLS
+#define FT8_LIKELIHOOD_SYMBOLS 1
+#endif
+#if FT8_LIKELIHOOD_SYMBOLS > 1
+extern int likelihood_symbols;  // Initially FT8_LIKELIHOOD_SYMBOLS
+#endif
+
+// A priori (AP) decoding:  while a QSO partner's reply is awaited, both callsigns of a standard message are known.
+// apply_apriori_callsigns() replaces the likelihoods of their 58 bits (c28 r1 c28 r1) and of i3 with those of the
+// bits in a77 (as packed by pack_callsigns()), at a magnitude slightly beyond any of the received bits, so the
+// LDPC decoder only has to find the remaining bits.
+const int kAP_callsign_bits = 58;
+void apply_apriori_callsigns(float *log174, const uint8_t *a77);
+
+// The payloads a timeslot has decoded, so repeated decodes of a signal are rejected before they're unpacked.
+// Open addressing over kPayload_set_slots 96-bit keys, each an a91[] whose CRC bits have been cleared.
+// payload_set_insert() returns false for a payload already present.  It also returns false when
+// kPayload_set_limit payloads are already held.
+const int kPayload_set_slots = 128;  // A power of 2
+const int kPayload_set_limit = 96;   // At most 3/4 full
+struct PayloadSet {
+  uint32_t key[kPayload_set_slots][3];
+  uint8_t used[kPayload_set_slots];
+  int count;
+};
+void payload_set_clear(PayloadSet &set);
+bool payload_set_insert(PayloadSet &set, const uint8_t *a91);
+
+// Successive interference cancellation:  subtract_signal() removes a decoded message's tones (from genft8()) from the
+// spectrogram, in every alt they overlap, so find_sync() and extract_likelihood() see the weaker signals beneath
+// them.  The signal's power is the median over its symbols of its tone's excess over the symbol's other tones.
+// Entries it accounts for to within 3 dB drop to their symbol's noise, and none is left below that noise.
+void subtract_signal(uint8_t *power, int num_blocks, int num_bins, Candidate cand, const uint8_t *tones);
+void subtract_signal(PackedRow *power, int num_blocks, int num_bins, Candidate cand, const uint8_t *tones);
 
 
 
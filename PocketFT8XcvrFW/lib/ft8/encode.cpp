@@ -27,12 +27,21 @@
 // extern uint16_t CRC_POLYNOMIAL;  // CRC-14 polynomial without the leading (MSB) 1
 // extern int CRC_WIDTH;
 
-// Returns 1 if an odd number of bits are set in x, zero otherwise
-uint8_t parity8(uint8_t x) {
-    x ^= x >> 4;  // a b c d ae bf cg dh
-    x ^= x >> 2;  // a b ac bd cae dbf aecg bfdh
-    x ^= x >> 1;  // a ab bac acbd bdcae caedbf aecgbfdh
-    return (x) & 1;
+// The parity bits each message bit feeds (the columns of kGenerator), laid out as the codeword's bits 88-183 in
+// MSB-first 32-bit words, so encode174() adds 32 parity bits at a time.  Bits 88-90, message bits, stay clear.
+static uint32_t generator_column[91][3];  // [K][3]
+static bool columns_ready;
+
+static void init_generator_columns(void) {
+    for (int k = 0; k < K; ++k) {
+        for (int i = 0; i < M; ++i) {
+            if (kGenerator[i][k >> 3] & (0x80 >> (k & 7))) {
+                int bit = K + i - 88;
+                generator_column[k][bit >> 5] |= 0x80000000u >> (bit & 31);
+            }
+        }
+    }
+    columns_ready = true;
 }
 
 // Encode a 91-bit message and return a 174-bit codeword.
@@ -43,54 +52,29 @@ uint8_t parity8(uint8_t x) {
 // [IN] message   - array of 91 bits stored as 12 bytes (MSB first)
 // [OUT] codeword - array of 174 bits stored as 22 bytes (MSB first)
 void encode174(const uint8_t* message, uint8_t* codeword) {
-    // Here we don't generate the generator bit matrix as in WSJT-X implementation
-    // Instead we access the generator bits straight from the binary representation in kGenerator
-
     // For reference:
     // codeword(1:K)=message
     // codeword(K+1:N)=pchecks
-
-    // printf("Encode ");
-    // for (int i = 0; i < K_BYTES; ++i) {
-    //     printf("%02x ", message[i]);
-    // }
-    // printf("\n");
-
-    // Fill the codeword with message and zeros, as we will only update binary ones later
-    for (int j = 0; j < (7 + N) / 8; ++j) {
-        codeword[j] = (j < K_BYTES) ? message[j] : 0;
+    if (!columns_ready) init_generator_columns();
+
+    // pchecks is the sum modulo 2 of the generator columns of the message's 1 bits
+    uint32_t pchecks[3] = {0, 0, 0};
+    for (int k = 0; k < K; ++k) {
+        uint32_t set = 0u - ((message[k >> 3] >> (7 - (k & 7))) & 1);  // All ones for a 1 bit
+        pchecks[0] ^= generator_column[k][0] & set;
+        pchecks[1] ^= generator_column[k][1] & set;
+        pchecks[2] ^= generator_column[k][2] & set;
     }
 
-    uint8_t col_mask = (0x80 >> (K % 8));  // bitmask of current byte
-    uint8_t col_idx = K_BYTES - 1;         // index into byte array
-
-    // Compute the first part of itmp (1:M) and store the result in codeword
-    for (int i = 0; i < M; ++i) {  // do i=1,M
-        // Fast implementation of bitwise multiplication and parity checking
-        // Normally nsum would contain the result of dot product between message and kGenerator[i],
-        // but we only compute the sum modulo 2.
-        uint8_t nsum = 0;
-        for (int j = 0; j < K_BYTES; ++j) {
-            uint8_t bits = message[j] & kGenerator[i][j];  // bitwise AND (bitwise multiplication)
-            nsum ^= parity8(bits);                         // bitwise XOR (addition modulo 2)
-        }
-        // Check if we need to set a bit in codeword
-        if (nsum % 2) {  // pchecks(i)=mod(nsum,2)
-            codeword[col_idx] |= col_mask;
-        }
-
-        col_mask >>= 1;
-        if (col_mask == 0) {
-            col_mask = 0x80;
-            ++col_idx;
-        }
+    // Bytes 0-10 are the message's, byte 11 its last 3 bits and the first 5 parity bits
+    for (int j = 0; j < K_BYTES - 1; ++j) {
+        codeword[j] = message[j];
     }
-
-    // printf("Result ");
-    // for (int i = 0; i < (N + 7) / 8; ++i) {
-    //     printf("%02x ", codeword[i]);
-    // }
-    // printf("\n");
+    for (int j = K_BYTES - 1; j < (7 + N) / 8; ++j) {
+        int byte = j - (K_BYTES - 1);
+        codeword[j] = (uint8_t)(pchecks[byte >> 2] >> (24 - 8 * (byte & 3)));
+    }
+    codeword[K_BYTES - 1] |= message[K_BYTES - 1];
 }
 
 // Compute 14-bit CRC for a sequence of given number of bits
@@ -98,34 +82,31 @@ void encode174(const uint8_t* message, uint8_t* codeword) {
 // [IN] num_bits - number of bits in the sequence
 uint16_t crc(uint8_t* message, int num_bits) {
     // Adapted from https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
-    // constexpr uint16_t  TOPBIT = (1 << (CRC_WIDTH - 1));
-    uint16_t TOPBIT = (1 << (CRC_WIDTH - 1));
-    // printf("CRC, %d bits: ", num_bits);
-    // for (int i = 0; i < (num_bits + 7) / 8; ++i) {
-    //     printf("%02x ", message[i]);
-    // }
-    // printf("\n");
+    const uint16_t TOPBIT = (1 << (CRC_WIDTH - 1));
+    const uint16_t MASK = (1 << CRC_WIDTH) - 1;
 
     uint16_t remainder = 0;
-    int idx_byte = 0;
-
-    // Perform modulo-2 division, a bit at a time.
-    for (int idx_bit = 0; idx_bit < num_bits; ++idx_bit) {
-        if (idx_bit % 8 == 0) {
-            // Bring the next byte into the remainder.
-            remainder ^= (message[idx_byte] << (CRC_WIDTH - 8));
-            ++idx_byte;
-        }
+    const int num_bytes = num_bits / 8;
+
+    // Perform modulo-2 division a byte at a time:  the remainder's top 8 bits and the next byte select
+    // the remainder of dividing those 8 bits, to which the remainder's other bits are shifted in.
+    for (int idx_byte = 0; idx_byte < num_bytes; ++idx_byte) {
+        uint8_t top = (uint8_t)((remainder >> (CRC_WIDTH - 8)) ^ message[idx_byte]);
+        remainder = ((remainder << 8) ^ kCRC14_table[top]) & MASK;
+    }
 
-        // Try to divide the current data bit.
-        if (remainder & TOPBIT) {
-            remainder = (remainder << 1) ^ CRC_POLYNOMIAL;
-        } else {
-            remainder = (remainder << 1);
+    // Then the remaining bits of a partial last byte a bit at a time
+    if (num_bits % 8) {
+        remainder ^= (message[num_bytes] << (CRC_WIDTH - 8));
+        for (int idx_bit = 0; idx_bit < num_bits % 8; ++idx_bit) {
+            if (remainder & TOPBIT) {
+                remainder = (remainder << 1) ^ CRC_POLYNOMIAL;
+            } else {
+                remainder = (remainder << 1);
+            }
         }
     }
-    // printf("CRC = %04xh\n", remainder & ((1 << CRC_WIDTH) - 1));
-    return remainder & ((1 << CRC_WIDTH) - 1);
+    return remainder & MASK;
 }
 
 // Generate FT8 tone sequence from payload data
@@ -11,74 +11,166 @@
  */
 
 #include <Arduino.h>
-#include <map>
 #include "ft8LibIfce.h"
 #include "message.h"
 #include "NODEBUG.h"
 #include "text.h"
 
-std::map<uint32_t, String> hashedCallsignTable;  // Surprise:  Implemented as an ordered map!
+// The hashed callsign table lives in static RAM and uses open addressing.  Slots are probed linearly
+// from a home slot chosen by bits 12..20 of the 22-bit key (the low 9 bits of its top 10), so every entry
+// that a 10, 12 or 22-bit key can match lies in the run of used slots that starts at that key's home slot.  Once
+// kHashed_callsign_entries slots are in use, the least recently saved or looked up entry is evicted.
+static const int kHashed_callsign_slots = 512;    // A power of 2
+static const int kHashed_callsign_entries = 384;  // At most 3/4 full, keeping probe runs short
+
+typedef struct HashedCallsign {
+    uint32_t key22;      // The callsign's full 22-bit hash
+    uint32_t lastUsed;   // hashedCallsignClock when last saved or looked up
+    char callsign[12];   // c11 and its terminator, empty for an unused slot
+} HashedCallsign;
+
+static HashedCallsign hashedCallsignTable[kHashed_callsign_slots];
+static uint32_t hashedCallsignEntries;  // Slots in use
+static uint32_t hashedCallsignClock;    // Counts saves and lookups, for LRU eviction
+static HashedCallsignStats hashedCallsignStats;
+
+// Bits 12..20 of key22, one of kHashed_callsign_slots
+static int homeSlot(uint32_t key22) {
+    return (key22 >> 12) & (kHashed_callsign_slots - 1);
+}
+
+/**
+ * @brief Find the entry matching a 10, 12 or 22-bit key
+ * @param keyBits #bits in key
+ * @param key The key (the top keyBits of a 22-bit key)
+ * @return Slot of the most recently used matching entry, or -1
+ */
+static int findHashedCallsign(int keyBits, uint32_t key) {
+    int best = -1;
+    for (int i = homeSlot(key << (22 - keyBits)); hashedCallsignTable[i].callsign[0]; i = (i + 1) & (kHashed_callsign_slots - 1)) {
+        if ((hashedCallsignTable[i].key22 >> (22 - keyBits)) != key) continue;
+        if (best < 0 || hashedCallsignTable[i].lastUsed > hashedCallsignTable[best].lastUsed) best = i;
+    }
+    return best;
+}
+
+/**
+ * @brief Empty a slot, moving later entries of its probe run back so none becomes unreachable
+ * @param i The slot
+ */
+static void removeHashedCallsign(int i) {
+    const int mask = kHashed_callsign_slots - 1;
+    for (int j = (i + 1) & mask; hashedCallsignTable[j].callsign[0]; j = (j + 1) & mask) {
+        // Entry j may fill slot i if i lies between its home slot and j
+        int home = homeSlot(hashedCallsignTable[j].key22);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            hashedCallsignTable[i] = hashedCallsignTable[j];
+            i = j;
+        }
+    }
+    hashedCallsignTable[i].callsign[0] = 0;
+    hashedCallsignEntries--;
+}
 
 /**
  * @brief Returns #entries in the hashedCallsignTable
+ * @param stats If not NULL, receives the table's hit, miss and eviction counts
  * @return Count of entries
  */
-uint32_t getHashedCallsignTableSize(void) {
-    return hashedCallsignTable.size();
+uint32_t getHashedCallsignTableSize(HashedCallsignStats* stats) {
+    if (stats != NULL) *stats = hashedCallsignStats;
+    return hashedCallsignEntries;
 }
 
 /**
- * @brief Record an entry in the hashedCallsignTable map for key
- * @param callsign The callsign to be associated with key
- * @param key22 Apparently caller always supplies a 22-bit key
- *
- * @note We don't actually use a hash table as we've already loaded std::map into memory
+ * @brief Empty the hashedCallsignTable and zero its counts
+ */
+void clearHashedCallsignTable(void) {
+    memset(hashedCallsignTable, 0, sizeof(hashedCallsignTable));
+    memset(&hashedCallsignStats, 0, sizeof(hashedCallsignStats));
+    hashedCallsignEntries = 0;
+    hashedCallsignClock = 0;
+}
+
+/**
+ * @brief Record callsign in the hashedCallsignTable under its 22-bit key
+ * @param callsign The callsign to be associated with key22
+ * @param key22 The callsign's 22-bit hash
  *
- * @note Recording an entry with a previously used key overwrites the existing entry
+ * @note Recording a callsign under a key already in use replaces that entry's callsign
  */
-static void save_hash(const char* callsign, uint32_t key22) {
-    uint32_t key10 = (key22 >> 12) & 0x3ff;  // Entries are apparently recorded using a 10-bit key
-    hashedCallsignTable[key10] = callsign;
-    // DPRINTF("save_hash('%s',key22=%d) used key10=%d, size()=%d\n", callsign, key22, key10, hashedCallsignTable.size());
+void saveHashedCallsign(const char* callsign, uint32_t key22) {
+    if (callsign == NULL || callsign[0] == 0) return;
+    key22 &= 0x3fffff;
 
-}  // add()
+    int i = findHashedCallsign(22, key22);
+    if (i < 0) {
+        // Make room by evicting the least recently used entry
+        if (hashedCallsignEntries >= kHashed_callsign_entries) {
+            int lru = -1;
+            for (int j = 0; j < kHashed_callsign_slots; ++j) {
+                if (hashedCallsignTable[j].callsign[0] && (lru < 0 || hashedCallsignTable[j].lastUsed < hashedCallsignTable[lru].lastUsed)) lru = j;
+            }
+            removeHashedCallsign(lru);
+            hashedCallsignStats.evictions++;
+        }
+        for (i = homeSlot(key22); hashedCallsignTable[i].callsign[0]; i = (i + 1) & (kHashed_callsign_slots - 1)) {
+        }
+        hashedCallsignEntries++;
+    }
+    hashedCallsignTable[i].key22 = key22;
+    hashedCallsignTable[i].lastUsed = ++hashedCallsignClock;
+    strlcpy(hashedCallsignTable[i].callsign, callsign, sizeof(hashedCallsignTable[i].callsign));
+    // DPRINTF("saveHashedCallsign('%s',key22=%lu) slot=%d, entries=%lu\n", callsign, key22, i, hashedCallsignEntries);
+}  // saveHashedCallsign()
 
 /**
  * @brief Lookup an entry in the hashedCallsignTable for key
- * @param hash_type #bits in the supplied key
+ * @param keyBits #bits in the supplied key (10, 12 or 22)
  * @param key The supplied key
  * @param c11 Buffer to receive the callsign
  * @return true==success
+ *
+ * @note A 10 or 12-bit key matching several entries finds the most recently used
+ */
+bool lookupHashedCallsign(int keyBits, uint32_t key, char* c11) {
+    int i = -1;
+    if (keyBits == 10 || keyBits == 12 || keyBits == 22) {
+        i = findHashedCallsign(keyBits, key & ((1u << keyBits) - 1));
+    }
+    if (i < 0) {
+        hashedCallsignStats.misses++;
+        return false;
+    }
+    hashedCallsignStats.hits++;
+    hashedCallsignTable[i].lastUsed = ++hashedCallsignClock;
+    strlcpy(c11, hashedCallsignTable[i].callsign, 12);
+    return true;
+}  // lookupHashedCallsign()
+
+/**
+ * @brief ft8_lib's save_hash():  Record callsign under its 22-bit key
+ */
+static void save_hash(const char* callsign, uint32_t key22) {
+    saveHashedCallsign(callsign, key22);
+}
+
+/**
+ * @brief ft8_lib's lookup_hash():  Lookup the callsign for a 10, 12 or 22-bit key
  */
 static bool lookup_hash(ftx_callsign_hash_type_t hash_type, uint32_t key, char* c11) {
     // DPRINTF("lookup_hash(hash_type=%d, key=%d)\n", hash_type, key);
-    //  Callsigns apparently are always recorded and retrieved using a 10-bit key
-    uint32_t key10;  // A 10-bit version of key
     switch (hash_type) {
-        case FTX_CALLSIGN_HASH_10_BITS:  // Caller supplied a 10-bit key
-            key10 = key;                 // Use supplied key as-is
-            break;
-        case FTX_CALLSIGN_HASH_12_BITS:  // Caller supplied a 12-bit key
-            key10 = key >> 2;            // Make a 10-bit key
-            break;
-        case FTX_CALLSIGN_HASH_22_BITS:  // Caller supplied a 22-bit key
-            key10 = key >> 12;           // Make a 10-bit key
-            break;
-        default:         // Caller supplied nonsense
-            key10 = -1;  // Then use nonsense key
-            break;
-    }
-    key10 = key10 & 0x3ff;
-    // DPRINTF("Calculated key10=%d\n", key10);
-    String s = hashedCallsignTable[key10];  // Always lookup callsign using a 10-bit key
-    // DPRINTF("lookup_hash(key10=%d) retrieved '%s'\n", key10, s.c_str());
-    if (s.length() > 0) {
-        strlcpy(c11, s.c_str(), 12);
-        return true;
-    } else {
-        return false;
+        case FTX_CALLSIGN_HASH_10_BITS:
+            return lookupHashedCallsign(10, key, c11);
+        case FTX_CALLSIGN_HASH_12_BITS:
+            return lookupHashedCallsign(12, key, c11);
+        case FTX_CALLSIGN_HASH_22_BITS:
+            return lookupHashedCallsign(22, key, c11);
+        default:  // Caller supplied nonsense
+            return lookupHashedCallsign(0, key, c11);
     }
-}  // lookup()
+}  // lookup_hash()
 
 /**
  * @brief ft8_lib-defined struct of pointers to our callsign hash map
@@ -196,6 +288,46 @@ int pack77(const char* msg, uint8_t* b77) {
     return rc;
 }  // pack77()
 
+/**
+ * @brief Pack the callsigns of a standard message into a 77-bit array
+ * @param call_to Destination station's callsign (field1)
+ * @param call_de Source station's callsign (field2)
+ * @param a77 The 77-bit array receives the packed message with an empty report/grid
+ * @return 0==success
+ *
+ * @note The callsigns are packed by pack28(), exactly as they would be in any standard
+ * message between the two stations.  The a priori decoder uses the first 58 bits and i3.
+ */
+int pack_callsigns(const char* call_to, const char* call_de, uint8_t* a77) {
+    ftx_message_t result;
+    ftx_message_init(&result);
+    ftx_message_rc_t rc = ftx_message_encode_std(&result, &hashingIfce, call_to, call_de, "");
+    memcpy(a77, result.payload, FTX_PAYLOAD_LENGTH_BYTES);
+    return rc;
+}  // pack_callsigns()
+
+/**
+ * @brief Check the callsigns of a packed message
+ * @param a77 The 77-bit message, e.g. from an a priori decode
+ * @param call_to Expected destination station's callsign (field1)
+ * @param call_de Expected source station's callsign (field2)
+ * @return true if the message unpacks with exactly those callsigns
+ *
+ * @note An a priori decode clamps the likelihoods of the callsign bits, but the LDPC decoder may
+ * still settle on a codeword whose CRC matches with other callsigns.  Only a decode whose unpacked
+ * callsigns are the expected ones may be reported as our QSO partner's reply.
+ */
+bool callsigns_match(const uint8_t* a77, const char* call_to, const char* call_de) {
+    char field1[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE];
+    char field2[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE];
+    char field3[FTX_REPORTS_BFRSIZE];
+    MsgType msgType;
+    if (unpack77_fields(a77, field1, field2, field3, &msgType) < 0) return false;
+    trimBracketsFromCallsign(field1);
+    trimBracketsFromCallsign(field2);
+    return strcmp(field1, call_to) == 0 && strcmp(field2, call_de) == 0;
+}  // callsigns_match()
+
 /**
  * @brief Helper function to trim angle brackets from a callsign string in-place
  * @param s Callsign string (may be NULL), too-short, or even empty
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include "msgTypes.h"
 
@@ -25,7 +26,25 @@ int unpack77(const uint8_t* a77, char* message);
 // Pack any supported FT8 text message into a 77-bit array
 int pack77(const char* msg, uint8_t* a77);  // Pack any supported FT8 message into c77
 
+// Pack the two callsigns of a standard message (and its i3) into a 77-bit array, leaving the report/grid empty
+int pack_callsigns(const char* call_to, const char* call_de, uint8_t* a77);
+
+// Whether an unpacked 77-bit message is from call_de to call_to, e.g. to verify an a priori decode
+bool callsigns_match(const uint8_t* a77, const char* call_to, const char* call_de);
+
 // Unlike trimCallsign(), this function trims brackets in-place from a callsign string
 void trimBracketsFromCallsign(char* s);  // Trims angle brackets from callsign in-place
 
-uint32_t getHashedCallsignTableSize(void); // #entries in table
\ No newline at end of file
+// Hashed callsign table activity since startup (or clearHashedCallsignTable())
+typedef struct HashedCallsignStats {
+    uint32_t hits;       // Lookups that found a callsign
+    uint32_t misses;     // Lookups that found none
+    uint32_t evictions;  // Least recently used entries dropped to make room
+} HashedCallsignStats;
+
+uint32_t getHashedCallsignTableSize(HashedCallsignStats* stats = NULL); // #entries in table
+
+// The table of callsigns ft8_lib records by their 22-bit hashes and looks up by 10, 12 or 22-bit hashes
+void saveHashedCallsign(const char* callsign, uint32_t key22);
+bool lookupHashedCallsign(int keyBits, uint32_t key, char* c11);  // keyBits 10, 12 or 22
+void clearHashedCallsignTable(void);
\ No newline at end of file
@@ -20,6 +20,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include "constants.h"
+#include "ldpc.h"
 
 // extern int ND;
 // extern int NS;
@@ -34,6 +35,8 @@
 // extern int K_BYTES;
 
 static int ldpc_check(uint8_t codeword[]);
+
+int ldpc_stall_iterations = LDPC_STALL_ITERATIONS;
 static float fast_tanh(float x);
 static float fast_atanh(float x);
 
@@ -126,27 +129,57 @@ void ldpc_decode(float codeword[], int max_iters, uint8_t plain[], int* ok) {
     *ok = min_errors;
 }
 
-//
-// does a 174-bit codeword pass the FT8's LDPC parity checks?
-// returns the number of parity errors.
-// 0 means total success.
-//
-static int ldpc_check(uint8_t codeword[]) {
-    int errors = 0;
+// Each parity check's bits as a mask over the packed hard decisions
+static uint32_t check_masks[83][kHard_words];  // [M], as kNrw
+static bool masks_ready;
 
+static void init_check_masks(void) {
     for (int j = 0; j < M; ++j) {
-        uint8_t x = 0;
         for (int i = 0; i < kNrw[j]; ++i) {
-            x ^= codeword[kNm[j][i] - 1];
-        }
-        if (x != 0) {
-            ++errors;
+            int bit = kNm[j][i] - 1;
+            check_masks[j][bit >> 5] |= 1u << (bit & 31);
         }
     }
+    masks_ready = true;
+}
+
+void pack_hard_decisions(const uint8_t plain[], uint32_t hard[]) {
+    for (int w = 0; w < kHard_words; ++w) hard[w] = 0;
+    for (int i = 0; i < N; ++i) hard[i >> 5] |= (uint32_t)(plain[i] != 0) << (i & 31);
+}
+
+// Cortex-M7 has no population count instruction, so fold the word to 4 bits and look up their parity
+static inline int parity32(uint32_t x) {
+    x ^= x >> 16;
+    x ^= x >> 8;
+    x ^= x >> 4;
+    return (0x6996 >> (x & 0x0F)) & 1;
+}
+
+int ldpc_syndrome_weight(const uint32_t hard[]) {
+    if (!masks_ready) init_check_masks();
+
+    int errors = 0;
+    for (int j = 0; j < M; ++j) {
+        uint32_t x = 0;
+        for (int w = 0; w < kHard_words; ++w) x ^= hard[w] & check_masks[j][w];
+        errors += parity32(x);
+    }
     return errors;
 }
 
-void bp_decode(float codeword[], int max_iters, uint8_t plain[], int* ok) {
+//
+// does a 174-bit codeword pass the FT8's LDPC parity checks?
+// returns the number of parity errors.
+// 0 means total success.
+//
+static int ldpc_check(uint8_t codeword[]) {
+    uint32_t hard[kHard_words];
+    pack_hard_decisions(codeword, hard);
+    return ldpc_syndrome_weight(hard);
+}
+
+void bp_decode(float codeword[], int max_iters, uint8_t plain[], int* ok, int* iterations) {
     float tov[N][3];
     float toc[M][7];
 
@@ -168,25 +201,32 @@ void bp_decode(float codeword[], int max_iters, uint8_t plain[], int* ok) {
         }
     }
 
-    for (int iter = 0; iter < max_iters; ++iter) {
+    int iter = 0;
+    int best_iter = 0;  // Iteration of the fewest parity errors so far
+    for (; iter < max_iters; ++iter) {
         float zn[N];
+        uint32_t hard[kHard_words] = {0};
 
         // Update bit log likelihood ratios (tov=0 in iter 0)
         for (int i = 0; i < N; ++i) {
             zn[i] = codeword[i] + tov[i][0] + tov[i][1] + tov[i][2];
             plain[i] = (zn[i] > 0) ? 1 : 0;
+            hard[i >> 5] |= (uint32_t)plain[i] << (i & 31);
         }
 
         // Check to see if we have a codeword (check before we do any iter)
-        int errors = ldpc_check(plain);
+        int errors = ldpc_syndrome_weight(hard);
 
         if (errors < min_errors) {
             // we have a better guess - update the result
             min_errors = errors;
+            best_iter = iter;
 
             if (errors == 0) {
                 break;  // Found a perfect answer
             }
+        } else if (ldpc_stall_iterations > 0 && iter - best_iter >= ldpc_stall_iterations) {
+            break;  // Give up on a candidate (likely noise) that has stopped improving
         }
 
         // Send messages from bits to check nodes
@@ -225,6 +265,306 @@ void bp_decode(float codeword[], int max_iters, uint8_t plain[], int* ok) {
     }
 
     *ok = min_errors;
+    if (iterations) *iterations = iter;
+}
+
+// Edge positions, so ms_decode() and bp_decode_batch() needn't search the tables for them:  check kMn[i][j]
+// holds bit i at kNm[kMn[i][j] - 1][bit_slot[i][j]], and bit kNm[i][j] lists check i at kMn[kNm[i][j] - 1][check_slot[i][j]]
+static uint8_t bit_slot[174][3];  // [N][3], as kMn
+static uint8_t check_slot[83][7];  // [M][7], as kNm
+static bool slots_ready;
+
+static void init_slots(void) {
+    for (int i = 0; i < M; ++i) {
+        for (int j = 0; j < kNrw[i]; ++j) {
+            int ibj = kNm[i][j] - 1;
+            for (int kk = 0; kk < 3; ++kk) {
+                if (kMn[ibj][kk] - 1 == i) {
+                    check_slot[i][j] = kk;
+                    bit_slot[ibj][kk] = j;
+                }
+            }
+        }
+    }
+    slots_ready = true;
+}
+
+#if LDPC_BATCH
+// fast_tanh() without branches, so the lanes' loops vectorize
+static inline float fast_tanh_lane(float x) {
+    float x2 = x * x;
+    float a = x * (945.0f + x2 * (105.0f + x2));
+    float b = 945.0f + x2 * (420.0f + x2 * 15.0f);
+    float t = a / b;
+    t = (x < -4.97f) ? -1.0f : t;
+    return (x > 4.97f) ? 1.0f : t;
+}
+
+static inline float fast_atanh_lane(float x) {
+    float x2 = x * x;
+    float a = x * (945.0f + x2 * (-735.0f + x2 * 64.0f));
+    float b = (945.0f + x2 * (-1050.0f + x2 * 225.0f));
+    return a / b;
+}
+
+// bp_decode_batch()'s messages, [edge][lane].  About 20 KB at 4 lanes, too much for the stack.
+static float batch_codeword[174][kLDPC_lanes];  // [N]
+static float batch_zn[174][kLDPC_lanes];        // [N]
+static float batch_tov[174][3][kLDPC_lanes];    // [N][3]
+static float batch_toc[83][7][kLDPC_lanes];     // [M][7]
+
+// Each lane performs bp_decode()'s operations in bp_decode()'s order, so its results are bit-exact.  A lane
+// stops where bp_decode() would (converged, stalled or max_iters) and keeps its results while the others go on.
+// The messages are computed check by check, from the edge tables, rather than bp_decode()'s bit by bit searches.
+void bp_decode_batch(LDPCBatch& batch, int max_iters) {
+    const int lanes = batch.num_lanes;
+    int min_errors[kLDPC_lanes];
+    int best_iter[kLDPC_lanes];  // Iteration of the fewest parity errors so far
+    bool active[kLDPC_lanes];
+    int num_active = lanes;
+
+    if (!slots_ready) init_slots();
+
+    for (int l = 0; l < kLDPC_lanes; ++l) {
+        for (int i = 0; i < N; ++i) batch_codeword[i][l] = (l < lanes) ? batch.codeword[l][i] : 0.0f;
+        min_errors[l] = M;
+        best_iter[l] = 0;
+        active[l] = l < lanes;
+    }
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            for (int l = 0; l < kLDPC_lanes; ++l) batch_tov[i][j][l] = 0;
+        }
+    }
+
+    int iter = 0;
+    for (; iter < max_iters; ++iter) {
+        // Update bit log likelihood ratios (tov=0 in iter 0)
+        for (int i = 0; i < N; ++i) {
+            for (int l = 0; l < kLDPC_lanes; ++l) {
+                batch_zn[i][l] = batch_codeword[i][l] + batch_tov[i][0][l] + batch_tov[i][1][l] + batch_tov[i][2][l];
+            }
+        }
+
+        // Check each lane still running for a codeword
+        for (int l = 0; l < lanes; ++l) {
+            if (!active[l]) continue;
+            uint32_t hard[kHard_words] = {0};
+            for (int i = 0; i < N; ++i) {
+                batch.plain[l][i] = (batch_zn[i][l] > 0) ? 1 : 0;
+                hard[i >> 5] |= (uint32_t)batch.plain[l][i] << (i & 31);
+            }
+            int errors = ldpc_syndrome_weight(hard);
+            bool done = false;
+            if (errors < min_errors[l]) {
+                min_errors[l] = errors;
+                best_iter[l] = iter;
+                done = errors == 0;
+            } else if (ldpc_stall_iterations > 0 && iter - best_iter[l] >= ldpc_stall_iterations) {
+                done = true;
+            }
+            if (done) {
+                active[l] = false;
+                batch.iterations[l] = iter;
+                --num_active;
+            }
+        }
+        if (num_active == 0) break;
+
+        // Send messages from bits to check nodes, then from check nodes to bits
+        for (int i = 0; i < M; ++i) {
+            const int num_bits = kNrw[i];
+            for (int j = 0; j < num_bits; ++j) {
+                const float* zn = batch_zn[kNm[i][j] - 1];
+                const float* tov = batch_tov[kNm[i][j] - 1][check_slot[i][j]];
+                float* toc = batch_toc[i][j];
+                for (int l = 0; l < kLDPC_lanes; ++l) toc[l] = fast_tanh_lane(-(zn[l] - tov[l]) / 2);
+            }
+            for (int j = 0; j < num_bits; ++j) {
+                float Tmn[kLDPC_lanes];
+                for (int l = 0; l < kLDPC_lanes; ++l) Tmn[l] = 1.0f;
+                for (int k = 0; k < num_bits; ++k) {
+                    if (k == j) continue;
+                    for (int l = 0; l < kLDPC_lanes; ++l) Tmn[l] *= batch_toc[i][k][l];
+                }
+                float* tov = batch_tov[kNm[i][j] - 1][check_slot[i][j]];
+                for (int l = 0; l < kLDPC_lanes; ++l) tov[l] = 2 * fast_atanh_lane(-Tmn[l]);
+            }
+        }
+    }
+
+    for (int l = 0; l < lanes; ++l) {
+        batch.ok[l] = min_errors[l];
+        if (active[l]) batch.iterations[l] = iter;
+    }
+}
+#endif  // LDPC_BATCH
+
+// Layered (serial schedule) sum-product:  rather than update every check from the previous iteration's
+// bit likelihoods, bp_decode_layered() updates one check at a time and refreshes the likelihoods of its bits
+// immediately, so later checks in the same iteration already see the new information.  It typically needs
+// about half the iterations of bp_decode().
+void bp_decode_layered(float codeword[], int max_iters, uint8_t plain[], int* ok, int* iterations) {
+    float zn[N];       // Bit log likelihood ratios
+    float tov[M][7];   // Check to bit messages, in kNm order
+
+    int min_errors = M;
+
+    for (int i = 0; i < N; ++i) {
+        zn[i] = codeword[i];
+    }
+    for (int i = 0; i < M; ++i) {
+        for (int j = 0; j < 7; ++j) {
+            tov[i][j] = 0;
+        }
+    }
+
+    int iter = 0;
+    int best_iter = 0;  // Iteration of the fewest parity errors so far
+    for (;; ++iter) {
+        uint32_t hard[kHard_words] = {0};
+        for (int i = 0; i < N; ++i) {
+            plain[i] = (zn[i] > 0) ? 1 : 0;
+            hard[i >> 5] |= (uint32_t)plain[i] << (i & 31);
+        }
+
+        // Check to see if we have a codeword (check before we do any iter)
+        int errors = ldpc_syndrome_weight(hard);
+
+        if (errors < min_errors) {
+            min_errors = errors;
+            best_iter = iter;
+
+            if (errors == 0) {
+                break;  // Found a perfect answer
+            }
+        } else if (ldpc_stall_iterations > 0 && iter - best_iter >= ldpc_stall_iterations) {
+            break;  // Give up on a candidate (likely noise) that has stopped improving
+        }
+        if (iter == max_iters) break;
+
+        for (int i = 0; i < M; ++i) {
+            float toc[7];
+            for (int j = 0; j < kNrw[i]; ++j) {
+                // Message from the bit to this check, less what the bit had received from it
+                toc[j] = zn[kNm[i][j] - 1] - tov[i][j];
+                zn[kNm[i][j] - 1] = toc[j];
+                toc[j] = fast_tanh(-toc[j] / 2);
+            }
+            for (int j = 0; j < kNrw[i]; ++j) {
+                float Tmn = 1.0f;
+                for (int k = 0; k < kNrw[i]; ++k) {
+                    if (k != j) {
+                        Tmn *= toc[k];
+                    }
+                }
+                tov[i][j] = 2 * fast_atanh(-Tmn);
+                zn[kNm[i][j] - 1] += tov[i][j];
+            }
+        }
+    }
+
+    *ok = min_errors;
+    if (iterations) *iterations = iter;
+}
+
+// extract_likelihood() normalizes log174[] to sigma 4, so 4 steps per unit spans +/-8 sigma in int8
+static const float kLLR_scale = 4.0f;
+
+void quantize_likelihood(const float log174[], int8_t llr[]) {
+    for (int i = 0; i < N; ++i) {
+        float q = log174[i] * kLLR_scale;
+        if (q > 127.0f) q = 127.0f;
+        if (q < -127.0f) q = -127.0f;
+        llr[i] = (int8_t)lrintf(q);
+    }
+}
+
+static int8_t saturate_message(int x) {
+    return (int8_t)((x > 127) ? 127 : ((x < -127) ? -127 : x));
+}
+
+// Same schedule as bp_decode(), but each check sends the smallest magnitude among its other bits, scaled by
+// 3/4 (normalized min-sum), in place of 2 * atanh(product of tanh()).  The sign rule is bp_decode()'s:  with
+// log(P(1) / P(0)) likelihoods, a check of d bits sends (-1)^d times the product of the other bits' signs.
+void ms_decode(const int8_t codeword[], int max_iters, uint8_t plain[], int* ok, int* iterations) {
+    int8_t tov[N][3];  // Check to bit messages
+    int8_t toc[M][7];  // Bit to check messages, then check to bit messages
+
+    int min_errors = M;
+
+    if (!slots_ready) init_slots();
+
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            tov[i][j] = 0;
+        }
+    }
+
+    int iter = 0;
+    int best_iter = 0;  // Iteration of the fewest parity errors so far
+    for (; iter < max_iters; ++iter) {
+        int16_t zn[N];
+        uint32_t hard[kHard_words] = {0};
+
+        // Update bit log likelihood ratios (tov=0 in iter 0)
+        for (int i = 0; i < N; ++i) {
+            zn[i] = codeword[i] + tov[i][0] + tov[i][1] + tov[i][2];
+            plain[i] = (zn[i] > 0) ? 1 : 0;
+            hard[i >> 5] |= (uint32_t)plain[i] << (i & 31);
+        }
+
+        int errors = ldpc_syndrome_weight(hard);
+
+        if (errors < min_errors) {
+            min_errors = errors;
+            best_iter = iter;
+
+            if (errors == 0) {
+                break;  // Found a perfect answer
+            }
+        } else if (ldpc_stall_iterations > 0 && iter - best_iter >= ldpc_stall_iterations) {
+            break;  // Give up on a candidate (likely noise) that has stopped improving
+        }
+
+        // Send messages from bits to check nodes, less what each bit had received from the check
+        for (int i = 0; i < M; ++i) {
+            for (int j = 0; j < kNrw[i]; ++j) {
+                int ibj = kNm[i][j] - 1;
+                toc[i][j] = saturate_message(zn[ibj] - tov[ibj][check_slot[i][j]]);
+            }
+        }
+
+        // Send messages from check nodes to bits:  the two smallest magnitudes cover every "all but one" minimum
+        for (int i = 0; i < M; ++i) {
+            int min1 = 127, min2 = 127, min_j = 0;
+            int negatives = kNrw[i] & 1;
+            for (int j = 0; j < kNrw[i]; ++j) {
+                int magnitude = (toc[i][j] < 0) ? -toc[i][j] : toc[i][j];
+                if (magnitude < min1) {
+                    min2 = min1;
+                    min1 = magnitude;
+                    min_j = j;
+                } else if (magnitude < min2) {
+                    min2 = magnitude;
+                }
+                negatives ^= (toc[i][j] < 0);
+            }
+            for (int j = 0; j < kNrw[i]; ++j) {
+                int magnitude = (((j == min_j) ? min2 : min1) * 3) >> 2;
+                toc[i][j] = (negatives ^ (toc[i][j] < 0)) ? -magnitude : magnitude;
+            }
+        }
+
+        for (int i = 0; i < N; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                tov[i][j] = toc[kMn[i][j] - 1][bit_slot[i][j]];
+            }
+        }
+    }
+
+    *ok = min_errors;
+    if (iterations) *iterations = iter;
 }
 
 // https://varietyofsound.wordpress.com/2011/02/14/efficient-tanh-computation-using-lamberts-continued-fraction/
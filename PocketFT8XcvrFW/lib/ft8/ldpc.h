@@ -1,4 +1,7 @@
-//#pragma once
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
 
 
 
@@ -8,7 +11,76 @@
 // ok == 87 means success.
 void ldpc_decode(float codeword[], int max_iters, uint8_t plain[], int *ok);
 
-void bp_decode(float codeword[], int max_iters, uint8_t plain[], int *ok);
+// *iterations (if not NULL) receives the number of iterations run:  0 when the hard decisions
+// already satisfied every parity check, max_iters when the decoder gave up.
+void bp_decode(float codeword[], int max_iters, uint8_t plain[], int *ok, int *iterations = NULL);
+
+// Layered (serial schedule) counterpart of bp_decode()
+void bp_decode_layered(float codeword[], int max_iters, uint8_t plain[], int *ok, int *iterations = NULL);
+
+// Select bp_decode()'s schedule for ft8_decode():  0==flooding, 1==layered (bp_decode_layered()).
+// LDPC_MIN_SUM takes precedence.  Override with -D LDPC_LAYERED=1.
+#ifndef LDPC_LAYERED
+#define LDPC_LAYERED 0
+#endif
+
+// Select ft8_decode()'s LDPC decoder:  0==bp_decode() (float sum-product), 1==ms_decode() (normalized
+// min-sum on quantized log-likelihoods).  Override with -D LDPC_MIN_SUM=1.
+#ifndef LDPC_MIN_SUM
+#define LDPC_MIN_SUM 0
+#endif
+
+// Candidates bp_decode_batch() decodes at once
+#ifndef LDPC_LANES
+#define LDPC_LANES 4
+#endif
+const int kLDPC_lanes = LDPC_LANES;
+
+// A batch of candidates for bp_decode_batch():  submit num_lanes (up to kLDPC_lanes) codewords, receive each lane's
+// plain[], error count (*ok) and iterations, as bp_decode() would return them.
+struct LDPCBatch {
+  int num_lanes;
+  const float *codeword[kLDPC_lanes];
+  uint8_t plain[kLDPC_lanes][174];  // [N]
+  int ok[kLDPC_lanes];
+  int iterations[kLDPC_lanes];
+};
+
+// bp_decode() of a batch of candidates in structure-of-arrays layout (lane innermost), so one walk of the
+// kNm/kMn tables serves every lane and the lane loops vectorize.  Not reentrant (static message arrays, about
+// 20 KB at 4 lanes).  Only built with LDPC_BATCH.
+void bp_decode_batch(LDPCBatch &batch, int max_iters);
+
+// Have ft8_decode() decode its candidates in batches with bp_decode_batch():  0==one at a time, and the batch
+// decoder isn't built.  Applies to bp_decode() only (not LDPC_MIN_SUM or LDPC_LAYERED).  Experimental:  on the
+// host it has measured between 0.8x and 1.1x bp_decode()'s speed, no gain, and the M7 has no float SIMD for its
+// lane loops.  Override with -D LDPC_BATCH=1.
+#ifndef LDPC_BATCH
+#define LDPC_BATCH 0
+#endif
+
+// Quantize 174 log-likelihoods, as normalized by extract_likelihood(), to int8 for ms_decode()
+void quantize_likelihood(const float log174[], int8_t llr[]);
+
+// Normalized min-sum counterpart of bp_decode():  int8 log-likelihoods and messages, int16 bit sums,
+// no divisions or transcendental approximations.
+void ms_decode(const int8_t codeword[], int max_iters, uint8_t plain[], int *ok, int *iterations = NULL);
+
+// Hard decisions packed for ldpc_syndrome_weight():  bit i of the codeword is bit i % 32 of hard[i / 32]
+const int kHard_words = 6;  // 192 bits
+void pack_hard_decisions(const uint8_t plain[], uint32_t hard[]);
+
+// Number of the 83 parity checks the packed hard decisions fail (0 for a codeword)
+int ldpc_syndrome_weight(const uint32_t hard[]);
+
+// The decoders give up once the number of parity errors has not improved for this many iterations;
+// 0 disables.  Noise-only candidates otherwise run all max_iters.  Disabled by default:  4 saves about 15% of
+// the iterations spent on noise but cuts off slowly converging frames, losing about 1% of them near the
+// decoding threshold (see test_ldpc_syndrome).  Override with -D LDPC_STALL_ITERATIONS=n.
+#ifndef LDPC_STALL_ITERATIONS
+#define LDPC_STALL_ITERATIONS 0
+#endif
+extern int ldpc_stall_iterations;  // Initially LDPC_STALL_ITERATIONS
 
 // Packs a string of bits each represented as a zero/non-zero byte in plain[],
 // as a string of packed bits starting from the MSB of the first byte of packed[]
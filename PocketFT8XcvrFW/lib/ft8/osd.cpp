@@ -0,0 +1,167 @@
+/*
+ * osd.cpp
+ *
+ * Ordered-statistics decoding (after Fossorier and Lin, as in WSJT-X's osd174_91):  sort the bits by
+ * reliability, find the 91 most reliable bits that can be chosen independently (the most reliable basis,
+ * by Gaussian elimination of the generator matrix in that order), re-encode their hard decisions, and test
+ * codewords differing from that in one or two basis bits.  The codeword with the least discrepancy from
+ * the likelihoods that also passes the CRC wins.
+ */
+
+#include "osd.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "constants.h"
+#include "encode.h"
+#include "ldpc.h"
+
+typedef uint32_t Word;
+struct Codeword {
+    Word w[kHard_words];  // Bit i of the codeword is bit i % 32 of w[i / 32], as pack_hard_decisions()
+};
+
+static inline bool test_bit(const Codeword& c, int i) {
+    return (c.w[i >> 5] >> (i & 31)) & 1;
+}
+
+static inline void xor_into(Codeword& c, const Codeword& d) {
+    for (int w = 0; w < kHard_words; ++w) c.w[w] ^= d.w[w];
+}
+
+// Sum of the reliabilities of the bits in which c differs from the hard decisions
+static float discrepancy(const Codeword& c, const Codeword& hard, const float reliability[]) {
+    float sum = 0;
+    for (int w = 0; w < kHard_words; ++w) {
+        Word d = c.w[w] ^ hard.w[w];
+        while (d) {
+            sum += reliability[(w << 5) + __builtin_ctz(d)];
+            d &= d - 1;
+        }
+    }
+    return sum;
+}
+
+// Does the codeword's message carry a valid CRC-14 (and isn't all zeros, which would)?
+static bool crc_valid(const Codeword& c) {
+    uint8_t a91[12];  // K_BYTES
+    memset(a91, 0, sizeof(a91));
+    bool zero = true;
+    for (int i = 0; i < K; ++i) {
+        if (test_bit(c, i)) {
+            a91[i >> 3] |= 0x80 >> (i & 7);
+            zero = false;
+        }
+    }
+    if (zero) return false;
+
+    uint16_t chksum = ((a91[9] & 0x07) << 11) | (a91[10] << 3) | (a91[11] >> 5);
+    a91[9] &= 0xF8;
+    a91[10] = 0;
+    a91[11] = 0;
+    return chksum == crc(a91, 96 - 14);
+}
+
+// A codeword must differ from the hard decisions in less than this fraction of the total reliability.  In
+// test_osd, frames OSD recovered from AWGN stayed under 0.062 while the codewords it found in noise that
+// passed the CRC started at 0.075.
+static const float kOSD_max_discrepancy = 0.07f;
+
+bool osd_decode(const float log174[], int order, uint8_t plain[]) {
+    float reliability[174];  // [N]
+    float total_reliability = 0;
+    Codeword hard;
+    memset(&hard, 0, sizeof(hard));
+    for (int i = 0; i < N; ++i) {
+        reliability[i] = fabsf(log174[i]);
+        total_reliability += reliability[i];
+        if (log174[i] > 0) hard.w[i >> 5] |= 1u << (i & 31);
+    }
+
+    // Bits in order of decreasing reliability (insertion sort; N is small)
+    uint8_t by_reliability[174];
+    for (int i = 0; i < N; ++i) {
+        int j = i;
+        for (; j > 0 && reliability[by_reliability[j - 1]] < reliability[i]; --j) by_reliability[j] = by_reliability[j - 1];
+        by_reliability[j] = i;
+    }
+
+    // The systematic generator matrix:  message bit k and the parity bits it feeds (encode174())
+    Codeword g[91];  // [K]
+    memset(g, 0, sizeof(g));
+    for (int k = 0; k < K; ++k) {
+        g[k].w[k >> 5] |= 1u << (k & 31);
+        for (int i = 0; i < M; ++i) {
+            if (kGenerator[i][k >> 3] & (0x80 >> (k & 7))) g[k].w[(K + i) >> 5] |= 1u << ((K + i) & 31);
+        }
+    }
+
+    // Gaussian elimination taking pivots in order of reliability, so row r of g ends up as the only row with
+    // a 1 at basis bit basis[r], and rows are in order of decreasing reliability
+    int basis[91];  // [K]
+    int rank = 0;
+    for (int p = 0; p < N && rank < K; ++p) {
+        int column = by_reliability[p];
+        int r = rank;
+        while (r < K && !test_bit(g[r], column)) ++r;
+        if (r == K) continue;  // Depends on more reliable bits
+
+        Codeword pivot = g[r];
+        g[r] = g[rank];
+        g[rank] = pivot;
+        for (int r2 = 0; r2 < K; ++r2) {
+            if (r2 != rank && test_bit(g[r2], column)) xor_into(g[r2], pivot);
+        }
+        basis[rank++] = column;
+    }
+    if (rank < K) return false;
+
+    // Order 0:  re-encode the hard decisions of the basis
+    Codeword c0;
+    memset(&c0, 0, sizeof(c0));
+    for (int r = 0; r < K; ++r) {
+        if (test_bit(hard, basis[r])) xor_into(c0, g[r]);
+    }
+
+    Codeword best;
+    const float max_discrepancy = kOSD_max_discrepancy * total_reliability;
+    float best_discrepancy = max_discrepancy;
+    float d = discrepancy(c0, hard, reliability);
+    if (d < best_discrepancy && crc_valid(c0)) {
+        best = c0;
+        best_discrepancy = d;
+    }
+
+    // Order 1 and 2 test patterns.  The CRC is only computed for a pattern closer than the best so far.
+    if (order >= 1) {
+        for (int r = 0; r < K; ++r) {
+            Codeword c = c0;
+            xor_into(c, g[r]);
+            d = discrepancy(c, hard, reliability);
+            if (d < best_discrepancy && crc_valid(c)) {
+                best = c;
+                best_discrepancy = d;
+            }
+        }
+    }
+    if (order >= 2) {
+        for (int r = K - kOSD_pair_span; r < K; ++r) {
+            Codeword c1 = c0;
+            xor_into(c1, g[r]);
+            for (int s = r + 1; s < K; ++s) {
+                Codeword c = c1;
+                xor_into(c, g[s]);
+                d = discrepancy(c, hard, reliability);
+                if (d < best_discrepancy && crc_valid(c)) {
+                    best = c;
+                    best_discrepancy = d;
+                }
+            }
+        }
+    }
+
+    if (best_discrepancy == max_discrepancy) return false;
+    for (int i = 0; i < N; ++i) plain[i] = test_bit(best, i);
+    return true;
+}
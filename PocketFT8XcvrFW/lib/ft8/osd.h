@@ -0,0 +1,19 @@
+/*
+ * osd.h
+ *
+ * Ordered-statistics decoding (OSD) of the (174,91) LDPC code, a fallback for candidates
+ * the belief propagation decoders leave a few parity checks short of a codeword.
+ */
+#pragma once
+
+#include <stdint.h>
+
+// Test patterns beyond the re-encoded most reliable basis:  order 1 flips each of its 91 bits, order 2
+// also flips each pair among its kOSD_pair_span least reliable bits.  The fixed number of patterns bounds
+// the cost of an invocation.
+const int kOSD_pair_span = 24;
+
+// Decode log174[] (log(P(1) / P(0)) as from extract_likelihood()) by ordered statistics of the given order
+// (0, 1 or 2).  Returns true, with the codeword's N bits in plain[], for the test pattern nearest log174[]
+// whose message has a valid CRC-14.
+bool osd_decode(const float log174[], int order, uint8_t plain[]);
@@ -68,6 +68,10 @@ void readConfigFile() {
     strlcpy(config.m2, doc["M2"] | "", sizeof(config.m2));                                               // Free text msg 2
     strlcpy(config.my_sota_ref, doc["my_sota_ref"] | "", sizeof(config.my_sota_ref));                    // My station's SOTA Reference
     config.tcxoCorrection = doc["tcxoCorrection"] | DEFAULT_TCXO_CORRECTION;                             // Ask Charlie for details
+    config.syncSearch = doc["syncSearch"] | DEFAULT_SYNC_SEARCH;                                         // Costas sync search strategy
+    config.decodeBudgetMs = doc["decodeBudgetMs"] | DEFAULT_DECODE_BUDGET_MS;                            // Decoder's deadline
+    config.earlyDecode = doc["earlyDecode"] | DEFAULT_EARLY_DECODE;                                      // Early decoding pass
+    config.sicPasses = doc["sicPasses"] | DEFAULT_SIC_PASSES;                                            // Interference cancellation
 
     configFile.close();
 
@@ -114,8 +114,10 @@ void loadSSB();
 time_t getTeensy3Time();
 void waitForFT8timeslot();
 void process_data();
+void service_audio();
 void update_synchronization();
-static void copy_to_fft_buffer(void*, const void*);
+static void poll_timeslot_start();
+static void count_lost_audio(unsigned long decodeStart, unsigned long blocksReadBefore, unsigned queuedBefore);
 
 // Enable comments in the JSON configuration file (Pure JSON doesn't support them... we're not that pure)
 #define ARDUINOJSON_ENABLE_COMMENTS 1
@@ -145,11 +147,10 @@ AudioAmplifier amp1;      // Receiver and waterfall perform *much* better with a
 AudioConnection patchCord1(adc1, amp1);
 AudioConnection patchCord2(amp1, queue1);
 static const unsigned audioQueueSize = 100;  // Number of blocks in the Teensy audio queue (one symbol's period requires 8 blocks)
+static unsigned long audioBlocksRead;        // Count of audio blocks taken from queue1
+unsigned long audioBlocksLost;               // Count of audio blocks lost while ft8_decode() stalled ingest
 
 // Audio pipeline buffers
-q15_t dsp_buffer[3 * input_gulp_size] __attribute__((aligned(4)));
-q15_t dsp_output[FFT_SIZE * 2] __attribute__((aligned(4)));  // TODO:  Move to DMAMEM?
-q15_t input_gulp[input_gulp_size] __attribute__((aligned(4)));
 
 // Global flag to disable the transmitter for testing
 // bool disable_xmit = false;  // Flag can be set with config params
@@ -168,6 +169,9 @@ int DSP_Flag;
 // Apparently set when the timeslot's received messages are ready to be decoded
 int decode_flag;
 
+// Set when enough of the timeslot has been received for ft8_decode_early()
+int early_decode_flag;
+
 // Initialized to 1 by setup() and the multitude of synchronization functions.  Set to 0 by
 // process_FT8_FFT() apparently at the end of a receive timeslot???
 int ft8_flag;
@@ -406,8 +410,8 @@ FLASHMEM void loop() {
     // Check station params to determine if we have everything required to transmit
     if (thisStation.canTransmit()) thisStation.setEnableTransmit(true);
 
-    // If it's not time to decode incoming messages, then it's time to grab the recv'd sigs from A/D
-    if (decode_flag == 0) process_data();
+    // Grab the recv'd sigs from A/D.  Decoding no longer stalls this as it works from its own spectrogram bank.
+    process_data();
 
     // Is there buffered time-domain data for the DSP logic to work with???
     if (DSP_Flag == 1) {
@@ -441,12 +445,31 @@ FLASHMEM void loop() {
 
     }  // DSP_Flag
 
+    // Have we acquired enough of the timeslot to decode its strongest signals?
+    if (early_decode_flag == 1) {
+        early_decode_flag = 0;
+        if (decode_flag == 0) {
+            unsigned long decodeStart = micros();  // Account for audio blocks arriving while we decode
+            unsigned long blocksReadBefore = audioBlocksRead;
+            unsigned queuedBefore = queue1.available();
+            ft8_decode_early();  // Record, and display, the strongest signals' messages
+            if (getNumDecoded() > 0) display_messages(getNumDecoded());
+            count_lost_audio(decodeStart, blocksReadBefore, queuedBefore);
+        }
+    }
+
     // Apparently:  Have we acquired all of the timeslot's receiver time-domain data?
     if (decode_flag == 1) {
         // unsigned long td0 = millis();
+        unsigned long decodeStart = micros();          // Account for audio blocks arriving while we decode
+        unsigned long blocksReadBefore = audioBlocksRead;
+        unsigned queuedBefore = queue1.available();
         num_decoded_msg = ft8_decode();  // Decode the received messages
         master_decoded = num_decoded_msg;
         decode_flag = 0;
+        count_lost_audio(decodeStart, blocksReadBefore, queuedBefore);
+
+        seq.keyDeferredXmit();  // Key, or disarm if it's too late, a transmission an early decode armed
 
         // If a message is waiting for transmission, turn-on the carrier and set xmit_flag to modulate it.
         // WARNING:  There may be some confusion about what Transmit_Armned really means.  But this is
@@ -555,11 +578,11 @@ FLASHMEM void loadSSB() {
  *
  * Does nothing if there's not enough (8 blocks) audio data available.
  *
- * Does ??? with dsp_buffer[]
+ * Each block is copied once, into audio_ring[], where extract_power() windows it in place.
  *
  * Sets DSP_Flag when there's work for the DSP logic
  *
- * There's likely a dependency that block_size==AUDIO_BLOCK_SIZE???
+ * There's a dependency that block_size==AUDIO_BLOCK_SAMPLES (checked below)
  *
  * Note:  If we sample for 12.64 seconds at 6400 samples/second, then we
  * anticipate acquiring 80896 samples during a complete timeslot.
@@ -569,20 +592,16 @@ FLASHMEM void loadSSB() {
  *
  **/
 void process_data() {
+    static_assert(block_size == AUDIO_BLOCK_SAMPLES, "audio_ring[] ingests whole queue blocks");
     unsigned count = queue1.available();
     if (count >= audioQueueSize) DPRINTF("*** Audio queue filled with %u blocks ***\n", count);
     if (count >= num_que_blocks) {
-        // Copy received audio from queue buffers to the FFT buffer
+        // Append received audio from queue buffers to the ring read by extract_power()
         for (int i = 0; i < num_que_blocks; i++) {
-            copy_to_fft_buffer(input_gulp + block_size * i, queue1.readBuffer());
+            ingest_audio_block((const q15_t*)queue1.readBuffer());
             queue1.freeBuffer();
         }
-
-        for (int i = 0; i < input_gulp_size; i++) {
-            dsp_buffer[i] = dsp_buffer[i + input_gulp_size];
-            dsp_buffer[i + input_gulp_size] = dsp_buffer[i + 2 * input_gulp_size];
-            dsp_buffer[i + 2 * input_gulp_size] = input_gulp[i];
-        }
+        audioBlocksRead += num_que_blocks;
 
         // There is apparently work to do for the DSP logic
         DSP_Flag = 1;
@@ -590,31 +609,37 @@ void process_data() {
 }  // process_data()
 
 /**
- * Copies one audio block of 16-bit words from source to destination
- *
- * @param destination Destination buffer
- * @param source Source buffer
+ * @brief Count the audio blocks lost while decoding
+ * @param decodeStart micros() when decoding began
+ * @param blocksReadBefore audioBlocksRead when decoding began
+ * @param queuedBefore queue1.available() when decoding began
  *
- * The AUDIO_BLOCK_SIZE appears to be cast-in-brass at 128 in AudioStream6400.h
+ * Any blocks the ADC produced during decoding that were neither consumed by service_audio() nor remain
+ * in queue1 were lost for want of audio memory.  Allow one block of slack for the block in progress.
+ */
+static void count_lost_audio(unsigned long decodeStart, unsigned long blocksReadBefore, unsigned queuedBefore) {
+    unsigned long produced = (unsigned long)((micros() - decodeStart) * (AUDIO_SAMPLE_RATE_EXACT / AUDIO_BLOCK_SAMPLES) / 1e6f);
+    unsigned long accounted = (audioBlocksRead - blocksReadBefore) + queue1.available() - queuedBefore;
+    if (produced > accounted + 1) audioBlocksLost += produced - accounted - 1;
+}  // count_lost_audio()
+
+/**
+ * @brief Keep ingesting received audio while ft8_decode() works through its candidates
  *
- **/
-static void copy_to_fft_buffer(void* destination, const void* source) {
-    const uint16_t* src = (const uint16_t*)source;
-    uint16_t* dst = (uint16_t*)destination;
-    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
-        *dst++ = *src++;  // real sample plus a zero for imaginary
+ * ft8_decode() calls here between candidates so the next timeslot's symbols are transformed into the
+ * spectrogram bank extract_power() now owns rather than piling up in queue1.  Only the acquisition side
+ * of loop() runs here:  the modulator, the Sequencer's timeslotEvent() and the UI wait for decoding to
+ * finish.
+ */
+void service_audio() {
+    if (xmit_flag == 1) return;  // The modulator paces itself with DSP_Flag in loop()
+    poll_timeslot_start();       // The next timeslot may begin while we decode
+    process_data();
+    if (DSP_Flag == 1) {
+        process_FT8_FFT();
+        DSP_Flag = 0;
     }
-
-    // //Configurable recording of raw 16-bit audio at 6400 samples/second to an SD file
-    // if (ft8Raw != NULL) {
-    //   ft8Raw.write(source, AUDIO_BLOCK_SAMPLES * sizeof(uint16_t));
-    //   recordSampleCount += AUDIO_BLOCK_SAMPLES;  //Increment count of recorded samples
-    //   if (recordSampleCount % (unsigned)AUDIO_SAMPLE_RATE == 0) {
-    //     DPRINTF("Audio recording in progress...\n");  //One second progress indicator
-    //   }
-    // }
-
-}  // copy_to_fft_buffer()
+}  // service_audio()
 
 // /**
 //  * Updates synchronization using Teensy's TimeLib
@@ -653,15 +678,19 @@ static void copy_to_fft_buffer(void* destination, const void* source) {
  *
  **/
 static unsigned long nextTimeSlot;
-void update_synchronization() {
+static bool timeslotEventPending;  // A timeslot began but the Sequencer hasn't yet been told
+
+/**
+ * @brief Start acquiring a new timeslot if one has begun
+ *
+ * This is the time-critical part of update_synchronization(), safe to call from service_audio() while
+ * ft8_decode() is busy.  Notifying the Sequencer is deferred to update_synchronization() so the previous
+ * timeslot's decoded messages reach it first.
+ */
+static void poll_timeslot_start() {
     current_time = millis();
     ft8_time = current_time - start_time;  // mS elapsed in current interval???
 
-    // ft8_hours = (int8_t)(ft8_time / 3600000);
-    // hours_fraction = ft8_time % 3600000;
-    // ft8_minutes = (int8_t)(hours_fraction / 60000);
-    // ft8_seconds = (int8_t)((hours_fraction % 60000) / 1000);
-
     // Charlie's original sync decision used 200 mS now 160 mS (one FT8 symbol time)
     // TODO:  Is our time accurate enough to reduce window below 160 mS???
     if (ft8_flag == 0 && ft8_time % 15000 <= 160) {
@@ -669,6 +698,32 @@ void update_synchronization() {
         FT_8_counter = 0;
         ft8_marker = 1;
         WF_counter = 0;
+        timeslotEventPending = true;
+    }
+}  // poll_timeslot_start()
+
+/**
+ * @brief Print what the decoder did in the last timeslot, a line per DecodeStats group
+ */
+static void print_decode_stats() {
+    DecodeStats stats;
+    getDecodeStats(&stats);
+    DPRINTF("  Candidates:  ldpcRunsSaved=%d, ldpcIterations=%d, candidatesSkipped=%d, duplicatesRejected=%d\n", stats.ldpc_runs_saved, stats.ldpc_iterations, stats.candidates_skipped, stats.duplicates_rejected);
+    DPRINTF("  Near misses:  apRuns=%d, apDecodes=%d, apRejected=%d, apSkipped=%d, osdRuns=%d, osdDecodes=%d, osdSkipped=%d, osdMaxUs=%lu\n", stats.ap_runs, stats.ap_decodes, stats.ap_rejected, stats.ap_skipped, stats.osd_runs, stats.osd_decodes, stats.osd_skipped, (unsigned long)stats.osd_max_us);
+    DPRINTF("  Passes:  earlyDecodes=%d, earlyRunsSaved=%d, sicPassDecodes=%d/%d/%d, sicUs=%lu\n", stats.early_decodes, stats.early_runs_saved, stats.sic_pass_decodes[0], stats.sic_pass_decodes[1], stats.sic_pass_decodes[2], (unsigned long)stats.sic_us);
+    DPRINTF("  Timing:  decodeMs=%ld, decodeOverruns=%d, maxOverrunMs=%ld\n", (long)stats.decode_ms, stats.decode_overruns, (long)stats.max_overrun_ms);
+}  // print_decode_stats()
+
+void update_synchronization() {
+    poll_timeslot_start();
+
+    // ft8_hours = (int8_t)(ft8_time / 3600000);
+    // hours_fraction = ft8_time % 3600000;
+    // ft8_minutes = (int8_t)(hours_fraction / 60000);
+    // ft8_seconds = (int8_t)((hours_fraction % 60000) / 1000);
+
+    if (timeslotEventPending) {
+        timeslotEventPending = false;
 
         // Notify sequencer
         seq.timeslotEvent();  // Increments sequence number for upcoming timeslot
@@ -685,7 +740,11 @@ void update_synchronization() {
         ui.displayDate(true);  // Force an update so display will change from yellow to green if GPS is acquired
 
         // Debug timeslot and sequencer problems
-        DPRINTF("-----Timeslot %lu:  Sequencer.state=%u, Transmit_Armned=%u, xmit_flag=%u, message='%s', autoReplyToCQ=%u, hashedCallsignTable.size=%u ---\n", seq.getSequenceNumber(), seq.getState(), Transmit_Armned, xmit_flag, get_message(), getAutoReplyToCQ(), getHashedCallsignTableSize());
+        HashedCallsignStats hashStats;
+        getHashedCallsignTableSize(&hashStats);
+        DPRINTF("-----Timeslot %lu:  Sequencer.state=%u, Transmit_Armned=%u, xmit_flag=%u, message='%s', autoReplyToCQ=%u ---\n", seq.getSequenceNumber(), seq.getState(), Transmit_Armned, xmit_flag, get_message(), getAutoReplyToCQ());
+        DPRINTF("  hashedCallsignTable.size=%u, hashHits=%lu, hashMisses=%lu, hashEvictions=%lu, audioBlocksLost=%lu, spectrogramOverruns=%u\n", getHashedCallsignTableSize(), (unsigned long)hashStats.hits, (unsigned long)hashStats.misses, (unsigned long)hashStats.evictions, audioBlocksLost, spectrogram_overruns);
+        print_decode_stats();
     }
 }  // update_synchronization()
 
@@ -1,50 +1,61 @@
-#include "NODEBUG.h"
-// #include "NODEBUG.h"
-#include <TimeLib.h>
+/**
+ * @brief The receiver's spectral front end
+ *
+ * extract_power() transforms the received time-domain audio in audio_ring[] into the
+ * log power spectrogram, export_fft_power[], consumed by find_sync() and extract_likelihood().
+ *
+ * @note This file deliberately avoids the display, UI and Teensy-specific code (see Waterfall.cpp)
+ * so the native environment can build it against the portable arm_math.h shim in
+ * test/test_native/include.
+ */
+#include <Arduino.h>
 
-#include "HX8357_t3n.h"
+#include "NODEBUG.h"
 #include "Process_DSP.h"
-#include "UserInterface.h"
-#include "WF_Table.h"
 #include "arm_math.h"
-#include "decode_ft8.h"
-// #include "display.h"
-#include "traffic_manager.h"
 
-extern HX8357_t3n tft;
-extern q15_t dsp_buffer[] __attribute__((aligned(4)));
-extern q15_t dsp_output[] __attribute__((aligned(4)));
+// Audio pipeline buffers.  process_data() appends each received queue block to audio_ring[] and
+// extract_power() windows the most recent 3 gulps straight out of the ring, so no samples are shifted
+// as each symbol arrives.  audio_ring_size is a power of two and a multiple of block_size so indices
+// wrap with a mask and a block never straddles the end of the ring.
+q15_t audio_ring[audio_ring_size] __attribute__((aligned(4)));
+unsigned audio_ring_head;
+q15_t dsp_output[FFT_SIZE * 2] __attribute__((aligned(4)));  // TODO:  Move to DMAMEM?
 q15_t window_dsp_buffer[FFT_SIZE] __attribute__((aligned(4)));
 
-uint8_t WF_index[900];
 float window[FFT_SIZE];
+q15_t window_q15[FFT_SIZE] __attribute__((aligned(4)));  // window[] in Q15 for arm_mult_q15()
 
-// extern uint16_t cursor_line;
-
-extern int ft8_flag, FT_8_counter, ft8_marker, decode_flag, WF_counter;
-extern int num_decoded_msg;
-
-// The follow two externs added to support timing investigation (only used for debugging)
-// extern int xmit_flag;
-// extern int Transmit_Armned;
+// Log power in Q8 spectrogram units, 5*ln(x), for the integer path.  log_mantissa[i] holds
+// 5*ln(1 + i/256) so log_power_q15() needs only a count of leading zeros and a lookup per bin.
+static int16_t log_mantissa[256];
+static const int32_t kLog_octave = 227130;  // 5*ln(2) in Q8 with 8 more fraction bits
+static const int32_t kLog_ten = 2947;       // 5*ln(10) in Q8
 
-static UserInterface& ui = UserInterface::getInstance();
-
-int master_offset, offset_step;
-// extern int CQ_Flag;
+int offset_step;
 
 // TODO:  Move to DMAMEM???
 q15_t FFT_Scale[FFT_SIZE * 2];
 q15_t FFT_Magnitude[FFT_SIZE];
 int32_t FFT_Mag_10[FFT_SIZE / 2];
-uint8_t FFT_Buffer[FFT_SIZE / 2];
 float mag_db[FFT_SIZE / 2 + 1];
 
 arm_rfft_instance_q15 fft_inst;
 arm_cfft_radix4_instance_q15 aux_inst;
 
-// Moved export_fft_power array into slower RAM2 on Teensy4.1 to save RAM1 for expanding feature code
-DMAMEM uint8_t export_fft_power[ft8_msg_samples * ft8_buffer * 4];
+// Moved the spectrogram into slower RAM2 on Teensy4.1 to save RAM1 for expanding feature code, unless it's
+// stored compactly (SPECTROGRAM_4BIT) where it fits in RAM1.  There are two banks so extract_power() can fill
+// one with the current timeslot while ft8_decode() decodes the previous timeslot from the other.  Ownership
+// passes from extract_power() to the decoder in handoff_spectrogram() and returns in release_spectrogram().
+#if SPECTROGRAM_4BIT
+uint8_t spectrogram_bank[2][spectrogram_size];  // Rows of PackedRow
+uint8_t symbol_power[4 * ft8_buffer];  // The latest symbol's rows, staged for packing and the waterfall
+#else
+DMAMEM uint8_t spectrogram_bank[2][spectrogram_size];
+#endif
+uint8_t* export_fft_power = spectrogram_bank[0];  // The bank extract_power() is filling
+static uint8_t* decode_fft_power = NULL;          // The bank owned by the decoder or NULL
+unsigned spectrogram_overruns;                    // Timeslots dropped as the decoder still owned its bank
 
 // void init_DSP(void) {
 //   arm_rfft_init_q15(&fft_inst, &aux_inst, FFT_SIZE, 0);  //T4.1
@@ -57,12 +68,15 @@ DMAMEM uint8_t export_fft_power[ft8_msg_samples * ft8_buffer * 4];
 void init_DSP(void) {
     // arm_rfft_init_q15(&fft_inst, &aux_inst, FFT_SIZE, 0, 1);
     arm_rfft_init_q15(&fft_inst, FFT_SIZE, 0, 1);
-    for (int i = 0; i < FFT_SIZE; ++i) window[i] = ft_blackman_i(i, FFT_SIZE);
-    offset_step = (int)ft8_buffer * 4;
+    for (int i = 0; i < FFT_SIZE; ++i) {
+        window[i] = ft_blackman_i(i, FFT_SIZE);
+        long w = lroundf(window[i] * 32768.0f);
+        window_q15[i] = (q15_t)((w > 32767) ? 32767 : w);
+    }
+    for (int i = 0; i < 256; ++i) log_mantissa[i] = (int16_t)lroundf(256 * 5.0f * logf(1.0f + i / 256.0f));
+    offset_step = spectrogram_time_rows * spectrogram_row_bytes(ft8_buffer);  // From one block's rows to the next
 }
 
-int max_bin, max_bin_number;
-
 float ft_blackman_i(int i, int N) {
     const float alpha = 0.16f;  // or 2860/18608
     const float a0 = (1 - alpha) / 2;
@@ -76,99 +90,225 @@ float ft_blackman_i(int i, int N) {
 }
 
 // Compute FFT magnitudes (log power) for each timeslot in the signal
+//
+// Only the band the decoder uses is converted; spectrogram columns below ft8_min_bin are left 0.
 void extract_power(int offset) {
     // DTRACE();
+#if SPECTROGRAM_4BIT
+    // Stage the symbol's 4 rows in symbol_power[], then pack them into the bank
+    int block = offset / offset_step;
+    uint8_t* power = symbol_power;
+    const int alt_stride = ft8_buffer;
+#else
+    uint8_t* power = &export_fft_power[offset];
+    const int alt_stride = spectrogram_alt_rows * spectrogram_row_bytes(ft8_buffer);  // See SPECTROGRAM_PLANAR
+#endif
 
     // Loop over two possible time offsets (0 and block_size/2)
     for (int time_sub = 0; time_sub <= input_gulp_size / 2; time_sub += input_gulp_size / 2) {
         // DTRACE();
-        for (int i = 0; i < FFT_SIZE; i++) window_dsp_buffer[i] = (q15_t)((float)dsp_buffer[i + time_sub] * window[i]);
+        window_audio(time_sub);
         // DTRACE();
         // DPRINTF("fft_inst.fftLenReal=%u\n", fft_inst.fftLenReal);
         arm_rfft_q15(&fft_inst, window_dsp_buffer, dsp_output);
         // DTRACE();
-        arm_shift_q15(&dsp_output[0], 5, &FFT_Scale[0], FFT_SIZE * 2);
-        // DTRACE();
-        arm_cmplx_mag_squared_q15(&FFT_Scale[0], &FFT_Magnitude[0], FFT_SIZE);
+        // Scale and square only the decoded band, ft8_min_bin..ft8_buffer
+        arm_shift_q15(&dsp_output[2 * ft8_first_fft_bin], 5, &FFT_Scale[2 * ft8_first_fft_bin], 2 * ft8_fft_bins);
         // DTRACE();
-        for (int j = 0; j < FFT_SIZE / 2; j++) {
-            FFT_Mag_10[j] = 10 * (int32_t)FFT_Magnitude[j];
-            mag_db[j] = 5.0 * log((float)FFT_Mag_10[j] + 0.1);
-        }
+        arm_cmplx_mag_squared_q15(&FFT_Scale[2 * ft8_first_fft_bin], &FFT_Magnitude[ft8_first_fft_bin], ft8_fft_bins);
         // DTRACE();
-        //  Loop over two possible frequency bin offsets (for averaging)
-        for (int freq_sub = 0; freq_sub < 2; ++freq_sub) {
-            for (int j = 0; j < ft8_buffer; ++j) {
-                float db1 = mag_db[j * 2 + freq_sub];
-                float db2 = mag_db[j * 2 + freq_sub + 1];
-                float db = (db1 + db2) / 2;
-
-                int scaled = (int)(db);
-                export_fft_power[offset] = (scaled < 0) ? 0 : ((scaled > 255) ? 255 : scaled);
-                ++offset;
-            }
-        }
+#if DSP_FIXED_POINT
+        log_power_q15(FFT_Magnitude, power, alt_stride);
+#else
+        log_power_float(FFT_Magnitude, power, alt_stride);
+#endif
+        power += 2 * alt_stride;
     }
+#if SPECTROGRAM_4BIT
+    PackedRow* packed = (PackedRow*)export_fft_power;
+    for (int alt = 0; alt < 4; ++alt) {
+        pack_power_row(&symbol_power[alt * ft8_buffer], &packed[block * spectrogram_time_rows + alt * spectrogram_alt_rows]);
+    }
+#endif
 }
 
-// KQ7B:  Calculates received signal powers and updates the waterfall
-void process_FT8_FFT(void) {
-    // Apparent check to ensure we are actively receiving data at this time???
-    if (ft8_flag == 1) {
-        master_offset = offset_step * FT_8_counter;
-        extract_power(master_offset);
-
-        update_offset_waterfall(master_offset);
-
-        FT_8_counter++;
-
-        // Apparently:  Have we processed the entire receive timeslot?
-        if (FT_8_counter == ft8_msg_samples) {
-            ft8_flag = 0;
-            decode_flag = 1;
-        }
+/**
+ * @brief Compress one spectrogram row into the 4-bit format
+ * @param row ft8_buffer one byte entries (only ft8_min_bin..ft8_buffer-1 are kept)
+ * @param packed The compact row
+ *
+ * The row's base sits a little below its mean, i.e. below the noise floor, so the 16 steps span the
+ * noise and the signals above it.  The step is the smallest power of two that reaches the row's peak.
+ * Entries below the base, deep in the noise, are clipped to it.
+ */
+void pack_power_row(const uint8_t* row, PackedRow* packed) {
+    const int kBase_below_mean = 12;  // Spectrogram units (10 dB)
+    row += ft8_min_bin;
+
+    int sum = 0, peak = 0;
+    for (int c = 0; c < packed_row_columns; ++c) {
+        sum += row[c];
+        if (row[c] > peak) peak = row[c];
     }
-}  // process_FT8_FFT()
-
-// Update the waterfall graphic with received signal powers and, at the end of a receive timeslot,
-// displays successfully decoded messages (if any).  Prepares to send CQ.
-void update_offset_waterfall(int offset) {
-    // DPRINTF("WF_counter=%u, num_decoded_msg=%u, FT_8_counter=%u, xmit_flag=%u, Transmit_Armned=%u\n", WF_counter, num_decoded_msg, FT_8_counter, xmit_flag, Transmit_Armned);
-
-    // DPRINTF("update_offset_waterfall(%d), WF_counter=%d\n", offset, WF_counter);
-
-    for (int j = ft8_min_bin; j < ft8_buffer; j++) FFT_Buffer[j] = export_fft_power[j + offset];
-
-    // DTRACE();
-
-    int bar;
-    for (int x = ft8_min_bin; x < ft8_buffer; x++) {
-        bar = FFT_Buffer[x];
-        if (bar > 63) bar = 63;
-        WF_index[x] = bar;
+    int base = sum / packed_row_columns - kBase_below_mean;
+    if (base < 0) base = 0;
+    int shift = 0;
+    while (shift < 7 && ((peak - base) >> shift) > 15) ++shift;
+    packed->base = base;
+    packed->shift = shift;
+
+    int half = (1 << shift) >> 1;
+    for (int c = 0; c < packed_row_columns; c += 2) {
+        int lo = (row[c] - base + half) >> shift;
+        int hi = (c + 1 < packed_row_columns) ? (row[c + 1] - base + half) >> shift : 0;
+        lo = (lo < 0) ? 0 : ((lo > 15) ? 15 : lo);
+        hi = (hi < 0) ? 0 : ((hi > 15) ? 15 : hi);
+        packed->nibbles[c >> 1] = (uint8_t)(lo | (hi << 4));
     }
-
-    // Draw waterfall pixels
-    for (int k = ft8_min_bin; k < ft8_buffer; k++) {
-        ui.drawWaterfallPixel(k - ft8_min_bin, WF_counter, (AColor)WFPalette[WF_index[k]]);
+}  // pack_power_row()
+
+/**
+ * @brief Convert FFT magnitudes to one time_sub's spectrogram entries using float log()
+ * @param magnitude FFT_Magnitude[] (squared magnitudes, 3.13), read from ft8_first_fft_bin
+ * @param row The ft8_buffer entries for frequency offset (freq_sub) 0
+ * @param freq_sub_stride Entries from freq_sub 0's row to freq_sub 1's
+ */
+void log_power_float(const q15_t* magnitude, uint8_t* row, int freq_sub_stride) {
+    for (int j = ft8_first_fft_bin; j < ft8_first_fft_bin + ft8_fft_bins; j++) {
+        FFT_Mag_10[j] = 10 * (int32_t)magnitude[j];
+        mag_db[j] = 5.0 * log((float)FFT_Mag_10[j] + 0.1);
     }
-
-    // At the beginning(!!!) of a timeslot, display recvd messages, and prepare to send CQ or respond to calls
-    if (WF_counter == 0) {
-        // DTRACE();
-        //  DPRINTF("WF_counter=%u, num_decoded_msg=%u, FT_8_counter=%u, xmit_flag=%u, Transmit_Armned=%u\n", WF_counter, num_decoded_msg, FT_8_counter, xmit_flag, Transmit_Armned);
-        if (num_decoded_msg > 0) {
-            display_messages(num_decoded_msg);  // Displays "all" received messages in lefthand text box
+    // DTRACE();
+    //  Loop over two possible frequency bin offsets (for averaging)
+    for (int freq_sub = 0; freq_sub < 2; ++freq_sub) {
+        uint8_t* entry = row + freq_sub * freq_sub_stride;
+        memset(entry, 0, ft8_min_bin);  // Below the decoded band
+        entry += ft8_min_bin;
+        for (int j = ft8_min_bin; j < ft8_buffer; ++j) {
+            float db1 = mag_db[j * 2 + freq_sub];
+            float db2 = mag_db[j * 2 + freq_sub + 1];
+            float db = (db1 + db2) / 2;
+
+            int scaled = (int)(db);
+            *entry++ = (scaled < 0) ? 0 : ((scaled > 255) ? 255 : scaled);
         }
-        // if (CQ_Flag == 1) {
-        //     //service_CQ();  // Drives the so-called beacon-mode state machine
-        // } else {
-        Check_Calling_Stations(num_decoded_msg);  // Displays messages sent to our station in righthand text box
-                                                  // }
     }
+}  // log_power_float()
+
+/**
+ * @brief Integer log power of one squared magnitude in Q8 spectrogram units
+ * @return 5*ln(10*m) (5*ln(0.1) for m==0) times 256
+ */
+static inline int32_t log_power_q8(q15_t m) {
+    if (m <= 0) return -kLog_ten;
+    int msb = 31 - __builtin_clz((uint32_t)m);                                   // m = 2^msb * (1 + f)
+    int f = (msb >= 8) ? ((m >> (msb - 8)) & 0xFF) : ((m << (8 - msb)) & 0xFF);  // f in 1/256ths
+    return kLog_ten + ((msb * kLog_octave) >> 8) + log_mantissa[f];
+}
 
-    num_decoded_msg = 0;
-
-    WF_counter++;
+/**
+ * @brief Convert FFT magnitudes to one time_sub's spectrogram entries with integer arithmetic
+ * @param magnitude FFT_Magnitude[] (squared magnitudes, 3.13), read from ft8_first_fft_bin
+ * @param row The ft8_buffer entries for frequency offset (freq_sub) 0
+ * @param freq_sub_stride Entries from freq_sub 0's row to freq_sub 1's
+ *
+ * Given the same magnitudes, agrees with log_power_float() to within one spectrogram unit (0.87 dB of
+ * power).  The Q15 window's rounding differs from the float window's, though, and where a quiet bin's
+ * squared magnitude is a few LSBs, flipping it by one may move its entry by as much as 12 units.
+ */
+void log_power_q15(const q15_t* magnitude, uint8_t* row, int freq_sub_stride) {
+    int32_t* db_q8 = FFT_Mag_10;  // Reuse the float path's scratch
+    for (int j = ft8_first_fft_bin; j < ft8_first_fft_bin + ft8_fft_bins; j++) db_q8[j] = log_power_q8(magnitude[j]);
+
+    for (int freq_sub = 0; freq_sub < 2; ++freq_sub) {
+        uint8_t* entry = row + freq_sub * freq_sub_stride;
+        memset(entry, 0, ft8_min_bin);  // Below the decoded band
+        entry += ft8_min_bin;
+        for (int j = ft8_min_bin; j < ft8_buffer; ++j) {
+            int32_t scaled = (db_q8[j * 2 + freq_sub] + db_q8[j * 2 + freq_sub + 1]) >> 9;  // Average of the pair
+            *entry++ = (scaled < 0) ? 0 : ((scaled > 255) ? 255 : scaled);
+        }
+    }
+}  // log_power_q15()
+
+/**
+ * @brief Append one block of received audio to audio_ring[]
+ * @param block block_size samples from the audio queue
+ */
+void ingest_audio_block(const q15_t* block) {
+    memcpy(&audio_ring[audio_ring_head & (audio_ring_size - 1)], block, block_size * sizeof(q15_t));
+    audio_ring_head += block_size;
+}  // ingest_audio_block()
+
+/**
+ * @brief Window FFT_SIZE samples of the ring into window_dsp_buffer[]
+ * @param time_sub Offset in samples from the oldest of the 3 most recent gulps
+ *
+ * The span begins time_sub samples into the 3 most recent gulps.  The loop is split where
+ * the span wraps around the end of the ring rather than masking every index.
+ */
+void window_audio(int time_sub) {
+#if DSP_FIXED_POINT
+    window_audio_q15(time_sub);
+#else
+    window_audio_float(time_sub);
+#endif
+}  // window_audio()
+
+// Index in audio_ring[] of the first sample windowed for time_sub, and the count before the ring wraps
+static inline unsigned window_start(int time_sub, int* first) {
+    unsigned start = (audio_ring_head - 3 * input_gulp_size + time_sub) & (audio_ring_size - 1);
+    *first = audio_ring_size - start;
+    if (*first > FFT_SIZE) *first = FFT_SIZE;
+    return start;
+}
 
-}  // update_offset_waterfall()
+void window_audio_float(int time_sub) {
+    int first;
+    const q15_t* src = &audio_ring[window_start(time_sub, &first)];
+    for (int i = 0; i < first; i++) window_dsp_buffer[i] = (q15_t)((float)src[i] * window[i]);
+    for (int i = first; i < FFT_SIZE; i++) window_dsp_buffer[i] = (q15_t)((float)audio_ring[i - first] * window[i]);
+}  // window_audio_float()
+
+void window_audio_q15(int time_sub) {
+    int first;
+    unsigned start = window_start(time_sub, &first);
+    arm_mult_q15(&audio_ring[start], window_q15, window_dsp_buffer, first);
+    if (first < FFT_SIZE) arm_mult_q15(audio_ring, &window_q15[first], &window_dsp_buffer[first], FFT_SIZE - first);
+}  // window_audio_q15()
+
+/**
+ * @brief Hand the filled spectrogram bank to the decoder and begin filling the other bank
+ * @return The bank to be decoded, or NULL if the timeslot was dropped
+ *
+ * @note process_FT8_FFT() calls here when the timeslot's final symbol has been transformed.  If the
+ * decoder still owns its bank (i.e. it hasn't finished the previous timeslot), that bank is never
+ * reclaimed:  the decoder may still be reading it, or writing it in subtract_signal().  Instead the
+ * timeslot just acquired is dropped, extract_power() refills its bank with the next timeslot, and
+ * the overrun is counted.
+ */
+const uint8_t* handoff_spectrogram(void) {
+    if (decode_fft_power != NULL) {
+        spectrogram_overruns++;
+        return NULL;
+    }
+    decode_fft_power = export_fft_power;
+    export_fft_power = (export_fft_power == spectrogram_bank[0]) ? spectrogram_bank[1] : spectrogram_bank[0];
+    return decode_fft_power;
+}  // handoff_spectrogram()
+
+/**
+ * @brief Retrieve the spectrogram bank owned by the decoder
+ * @return The bank or NULL if none has been handed off
+ */
+const uint8_t* decode_spectrogram(void) {
+    return decode_fft_power;
+}  // decode_spectrogram()
+
+/**
+ * @brief Return the decoder's spectrogram bank to extract_power()
+ * @param bank The bank obtained from decode_spectrogram()
+ */
+void release_spectrogram(const uint8_t* bank) {
+    if (bank == decode_fft_power) decode_fft_power = NULL;
+}  // release_spectrogram()
@@ -184,6 +184,7 @@ static bool autoReplyToCQ;  // RoboOp automatically transmits reply to CQ
 void Sequencer::begin(unsigned timeoutSeconds, const char* logfileName) {
     DTRACE();
     sequenceNumber = 0;                                                      // Reset timeslot counter
+    xmitDeferred = false;                                                    // No transmission awaits keying
     state = IDLE;                                                            // Reset state to idle
     timeoutTimer = Timer::buildTimer(timeoutSeconds * 1000L, onTimerEvent);  // Build the QSO/tuning timeout-timer
     contactLog = LogFactory::buildADIFlog(logfileName);
@@ -211,6 +212,9 @@ void Sequencer::begin(unsigned timeoutSeconds, const char* logfileName) {
 void Sequencer::timeslotEvent() {
     DPRINTF("%s sequenceNumber=%lu, state=%u\n", __FUNCTION__, sequenceNumber, state);
 
+    // A reply an early decode armed in the timeslot just ended is keyed now if ft8_decode() didn't run to key it
+    keyDeferredXmit();
+
     // Review and purge ancient messages from UI (this is how we dispose of old messages)
     ui.theQSOMsgs->reviewTimeStamps();      // Messages sent to our station
     ui.allDecodedMsgs->reviewTimeStamps();  // All decoded messages
@@ -513,7 +517,7 @@ void Sequencer::cqMsgEvent(Decode* msg) {
     switch (state) {
         case IDLE:
             DTRACE();
-            startQSO(msg->field2, ODD(msg->sequenceNumber));
+            startQSO(msg->field2, ODD(msg->sequenceNumber), msg->freq_hz);
             contact.setWorkedLocator(msg->field3);  // Record their locator if we recvd it
             setXmitParams(msg->field2, msg->snr);   // Inform gen_ft8 of remote station's info
             DPRINTF("Target_Call='%s', msg.field2='%s', msg.rsl=%d, Target_RSL=%d msg.sequenceNumber=%lu, contact.oddEven=%u\n", Target_Call, msg->field2, msg->snr, Target_RSL, msg->sequenceNumber, contact.oddEven);
@@ -673,6 +677,12 @@ void Sequencer::cqButtonEvent() {
  *
  **/
 void Sequencer::clickDecodedMessageEvent(unsigned msgIndex) {
+    // The box's paging row shows its next page of messages rather than selecting one
+    if ((int)msgIndex == display_paging_row_index()) {
+        display_next_page();
+        return;
+    }
+
     // Find the decoded message as we need some info from it
     Decode* msg = getDecodedMsg(msgIndex);
     clickDecodedMessageEvent(msg);
@@ -716,7 +726,7 @@ void Sequencer::clickDecodedMessageEvent(Decode* msg) {
         clearOutboundMessageText();                   // Clear outbound message text chars
 
         // Start a QSO contact for the remote station
-        startQSO(msg->field2, ODD(msg->sequenceNumber));
+        startQSO(msg->field2, ODD(msg->sequenceNumber), msg->freq_hz);
         contact.setWorkedLocator(msg->field3);  // Record their locator if we have it
         setXmitParams(msg->field2, msg->snr);   // Inform gen_ft8 of remote station's info
         DPRINTF("Target_Call='%s', msg.field2='%s', msg.rsl=%d, Target_RSL=%d msg.sequenceNumber=%lu, contact.oddEven=%u\n", Target_Call, msg->field2, msg->snr, Target_RSL, msg->sequenceNumber, contact.oddEven);
@@ -882,7 +892,7 @@ void Sequencer::rslMsgEvent(Decode* msg) {
         // QSO from what we've heard.
         case LISTEN_LOC:
             DTRACE();
-            startQSO(msg->field2, ODD(msg->sequenceNumber));
+            startQSO(msg->field2, ODD(msg->sequenceNumber), msg->freq_hz);
             contact.setMyRSL(msg->field3);         // Record our RSL from remote station
             contact.setWorkedRSL(msg->snr);        // Record their RSL at the same time as ours
             setXmitParams(msg->field2, msg->snr);  // Inform gen_ft8 of remote station's info
@@ -1014,7 +1024,7 @@ void Sequencer::locatorEvent(Decode* msg) {
         case CQ_PENDING:  // We were going to [re]transmit CQ but received this msg first
         case LISTEN_LOC:  // We were listening for a response to our CQ and received this msg
             DTRACE();
-            startQSO(msg->field2, ODD(sequenceNumber));
+            startQSO(msg->field2, ODD(sequenceNumber), msg->freq_hz);
             // contact.begin(thisStation.getCallsign(), msg->field2, thisStation.getFrequency(), "FT8", thisStation.getRig(), ODD(sequenceNumber), thisStation.getSOTAref());  // Start gathering QSO info
             contact.setWorkedLocator(msg->field3);  // Record responder's locator
             setXmitParams(msg->field2, msg->snr);   // Inform gen_ft8 of remote station's info
@@ -1095,7 +1105,13 @@ void Sequencer::actionPendXmit(unsigned oddEven, SequencerStateType newState) {
     // have to wait a while for the remote station to be listening.
     if (oddEven == ODD(sequenceNumber)) {
         Transmit_Armned = 1;                                // Yes, transmit in the next slot
-        setup_to_transmit_on_next_DSP_Flag();               // loop() begins modulation in next timeslot
+        if (decoding_early()) {
+            // The timeslot is still being received, so keyDeferredXmit() keys the transmitter once it ends
+            xmitDeferred = true;
+            xmitDeferredSequence = sequenceNumber;
+        } else {
+            setup_to_transmit_on_next_DSP_Flag();  // loop() begins modulation in next timeslot
+        }
         state = newState;                                   // Advance state machine to new state after arming the transmitter
         ui.setXmitRecvIndicator(INDICATOR_ICON_TRANSMIT);   // Transmission will begin in loop()
         String thisTransmittedMsg = String(get_message());  // The pending outbound message text
@@ -1112,20 +1128,38 @@ void Sequencer::actionPendXmit(unsigned oddEven, SequencerStateType newState) {
 
 }  // actionPendXmit()
 
+/**
+ * @brief Key the transmitter for a transmission an early decode armed
+ *
+ * actionPendXmit() arms but doesn't key the transmitter while ft8_decode_early() runs, as the timeslot
+ * is still being received.  loop() calls here once ft8_decode() has finished the timeslot, and
+ * timeslotEvent() in case it didn't run.  The transmission is keyed only at the end of the timeslot it
+ * was armed in:  later, keying it would transmit in the wrong parity over the remote station, so it's
+ * disarmed instead.
+ */
+void Sequencer::keyDeferredXmit() {
+    if (!xmitDeferred) return;
+    xmitDeferred = false;
+    if (xmitDeferredSequence != sequenceNumber) {
+        DPRINTF("Disarming transmission armed in timeslot %lu, now %lu\n", xmitDeferredSequence, sequenceNumber);
+        Transmit_Armned = 0;
+        highlightAbortedTransmission();                   // Let our operator know it wasn't sent
+        ui.setXmitRecvIndicator(INDICATOR_ICON_RECEIVE);  // Still receiving
+        return;
+    }
+    if (Transmit_Armned == 1 && xmit_flag == 0) setup_to_transmit_on_next_DSP_Flag();  // loop() begins modulation in next timeslot
+}  // keyDeferredXmit()
+
 /**
  *  @brief Helper routine to retrieve pointer to a decoded message
  *
- *  @param msgIndex Index of decoded message
+ *  @param msgIndex Index of decoded message in the Decoded Messages box
  *
- *  @return pointer to Decode entry or NULL if msgIndex invalid
+ *  @return pointer to Decode entry in the decode arena or NULL if msgIndex invalid
  *
  **/
-extern Decode new_decoded[];  // References decode_ft8.cpp defining 20 elements
 Decode* Sequencer::getDecodedMsg(unsigned msgIndex) {
-    if (msgIndex < 20)
-        return &new_decoded[msgIndex];
-    else
-        return NULL;
+    return getDisplayedDecode((int)msgIndex);
 }
 
 /**
@@ -1146,6 +1180,14 @@ SequencerStateType Sequencer::getState() {
     return state;
 }  // getState()
 
+/**
+ * @brief Get the audio frequency at which we heard the worked station
+ * @return Frequency in Hz
+ */
+int Sequencer::getWorkedFreq() {
+    return workedFreq;
+}  // getWorkedFreq()
+
 /**
  * @brief Start the QSO timeout timer
  *
@@ -1174,6 +1216,7 @@ void Sequencer::stopTimer() {
  * @brief Helper routine to start a QSO
  * @param workedCall The remote station's callsign
  * @param oddEven Remote station expected to transmit in 1==odd, 0==even-numbered timeslots
+ * @param freq Audio frequency (Hz) of the remote station's message
  *
  * Manages details around starting a new QSO:
  *  + Initialize the contact object with information about this QSO
@@ -1183,7 +1226,7 @@ void Sequencer::stopTimer() {
  * for any of many reasons (QRM, QSB, QLF, QRT...).
  *
  */
-void Sequencer::startQSO(const char* workedCall, unsigned oddEven) {
+void Sequencer::startQSO(const char* workedCall, unsigned oddEven, int freq) {
     static const char* emptyString = "";
     DTRACE();
 
@@ -1194,6 +1237,7 @@ void Sequencer::startQSO(const char* workedCall, unsigned oddEven) {
     if (workedCall == NULL) workedCall = emptyString;
 
     // Activate this contact
+    workedFreq = freq;  // Where ft8_decode() looks for their replies
     contact.begin(thisStation.getCallsign(), workedCall, thisStation.getFrequency(), "FT8", thisStation.getRig(), oddEven, thisStation.getSOTAref());
 
     // Record some info known about this contact
@@ -2,8 +2,109 @@
 
 #include <Arduino.h>
 
+#include "NODEBUG.h"
+#include "PocketFT8Xcvr.h"
 #include "Process_DSP.h"
 #include "Station.h"
+#include "UserInterface.h"
+#include "WF_Table.h"
+#include "decode_ft8.h"
+#include "traffic_manager.h"
+
+uint8_t WF_index[900];
+uint8_t FFT_Buffer[FFT_SIZE / 2];
+
+extern int offset_step;
+
+// extern uint16_t cursor_line;
+
+extern int ft8_flag, FT_8_counter, ft8_marker, decode_flag, early_decode_flag, WF_counter;
+extern int num_decoded_msg;
+
+// The follow two externs added to support timing investigation (only used for debugging)
+// extern int xmit_flag;
+// extern int Transmit_Armned;
+
+static UserInterface& ui = UserInterface::getInstance();
+
+int master_offset;
+static bool messages_pending;  // Decoded messages await display
+// extern int CQ_Flag;
+
+int max_bin, max_bin_number;
+
+// KQ7B:  Calculates received signal powers and updates the waterfall
+void process_FT8_FFT(void) {
+    // Apparent check to ensure we are actively receiving data at this time???
+    if (ft8_flag == 1) {
+        master_offset = offset_step * FT_8_counter;
+        extract_power(master_offset);
+
+        update_offset_waterfall(master_offset);
+
+        FT_8_counter++;
+
+        // Enough of the timeslot for the strongest signals?  If so, loop() runs the early decoding pass.
+        if (FT_8_counter == (int)config.earlyDecode) early_decode_flag = 1;
+
+        // Apparently:  Have we processed the entire receive timeslot?  If so, pass it to the decoder unless it's still busy.
+        if (FT_8_counter == ft8_msg_samples) {
+            if (handoff_spectrogram() != NULL) decode_flag = 1;
+            ft8_flag = 0;
+        }
+    }
+}  // process_FT8_FFT()
+
+// Update the waterfall graphic with received signal powers and, at the end of a receive timeslot,
+// displays successfully decoded messages (if any).  Prepares to send CQ.
+void update_offset_waterfall(int offset) {
+    // DPRINTF("WF_counter=%u, num_decoded_msg=%u, FT_8_counter=%u, xmit_flag=%u, Transmit_Armned=%u\n", WF_counter, num_decoded_msg, FT_8_counter, xmit_flag, Transmit_Armned);
+
+    // DPRINTF("update_offset_waterfall(%d), WF_counter=%d\n", offset, WF_counter);
+
+#if SPECTROGRAM_4BIT
+    const uint8_t* power = symbol_power;  // The symbol's rows before extract_power() packed them
+#else
+    const uint8_t* power = &export_fft_power[offset];
+#endif
+    for (int j = ft8_min_bin; j < ft8_buffer; j++) FFT_Buffer[j] = power[j];
+
+    // DTRACE();
+
+    int bar;
+    for (int x = ft8_min_bin; x < ft8_buffer; x++) {
+        bar = FFT_Buffer[x];
+        if (bar > 63) bar = 63;
+        WF_index[x] = bar;
+    }
+
+    // Draw waterfall pixels
+    for (int k = ft8_min_bin; k < ft8_buffer; k++) {
+        ui.drawWaterfallPixel(k - ft8_min_bin, WF_counter, (AColor)WFPalette[WF_index[k]]);
+    }
+
+    // At the beginning(!!!) of a timeslot, display recvd messages, and prepare to send CQ or respond to calls.
+    // The previous timeslot may still be decoding while service_audio() transforms the first symbols of
+    // this one, in which case the display waits for the decoder to finish.
+    if (WF_counter == 0) messages_pending = true;
+    if (messages_pending && decode_flag == 0) {
+        // DTRACE();
+        //  DPRINTF("WF_counter=%u, num_decoded_msg=%u, FT_8_counter=%u, xmit_flag=%u, Transmit_Armned=%u\n", WF_counter, num_decoded_msg, FT_8_counter, xmit_flag, Transmit_Armned);
+        if (num_decoded_msg > 0) {
+            display_messages(num_decoded_msg);  // Displays "all" received messages in lefthand text box
+        }
+        // if (CQ_Flag == 1) {
+        //     //service_CQ();  // Drives the so-called beacon-mode state machine
+        // } else {
+        Check_Calling_Stations();  // Displays messages sent to our station in righthand text box
+                                                  // }
+        messages_pending = false;
+        num_decoded_msg = 0;
+    }
+
+    WF_counter++;
+
+}  // update_offset_waterfall()
 
 // // Define the three frequencies associated with the Waterfall
 // // uint16_t cursor_freq;      // Frequency of cursor line
@@ -23,4 +124,4 @@
 //     thisStation.setCursorFreq((uint16_t)((float)(cursor_line + ft8_min_bin) * FFT_Resolution));
 //     // offset_freq = start_up_offset_freq;
 //     //  DPRINTF("initCursorFrequency:  start_up_offset_freq=%d, cursor_freq=%d, offset_freq=%d\n", start_up_offset_freq, cursor_freq, offset_freq);
-// }  // initCursorFrequency()
\ No newline at end of file
+// }  // initCursorFrequency()
@@ -29,23 +29,34 @@
 #include "ldpc.h"
 #include "ft8LibIfce.h"
 #include "message.h"
+#include "osd.h"
 
 extern HX8357_t3n tft;
 
 char erase[] = "                   ";
 
 const int kLDPC_iterations = 10;
-const int kMax_candidates = 20;
-const int kMax_decoded_messages = 9;  // chhh 27 feb
+const int kMax_candidates = 30;       // Was 20 before find_sync() vectorized its row sums
+const int kCandidate_pool = 60;       // find_sync()'s candidates before suppress_candidates() merges duplicates
 const int kMax_message_length = 24;   // Was 22 (KQ7B)
 
 const int kMin_score = 40;  // Minimum sync score threshold for candidates (40)
 
+const int kOSD_max_candidates = 4;         // Near misses kept for the ordered-statistics fallback
+const int kOSD_max_errors = 12;            // Parity checks a near miss may leave unsatisfied
+const int kOSD_order = 2;                  // See osd.h
+const uint32_t kOSD_first_cost_us = 5000;  // Assumed OSD cost until one has been measured
+
+const int kAP_max_candidates = 3;  // LDPC reruns per timeslot with the QSO partner's callsigns known a priori
+const int kAP_freq_span = 10;      // Hz either side of the QSO partner's frequency eligible for AP reruns
+
 int validate_locator(char locator[]);
 int strindex(const char s[], const char t[]);
 
 extern uint32_t ft8_time;
-extern uint8_t export_fft_power[ft8_msg_samples * ft8_buffer * 4];
+extern uint32_t start_time;  // millis() at the beginning of a timeslot (see update_synchronization())
+extern int FT_8_counter;     // Symbols process_FT8_FFT() has transformed into the acquiring bank
+extern void service_audio(void);  // Defined in PocketFT8XcvrFW.cpp
 
 // extern int ND;
 // extern int NS;
@@ -64,7 +75,16 @@ static Station& thisStation = Station::getInstance();
 
 // extern void write_log_data(char *data);
 
-Decode new_decoded[20];
+// The decode arena:  the timeslot's decoded messages in the order ft8_decode() decoded them
+static Decode decodes[kMax_decodes];
+static int num_decodes;
+
+// The arena entries displayed in the Decoded Messages box, by row
+static int displayed_decodes[DISPLAY_DECODED_LINES];
+static int num_displayed_decodes;
+static int display_page_start;       // Arena index of the first message the box's page considers
+static int display_next_page_start;  // Arena index the paging row advances to, 0 to return to the first page
+static int display_paging_row = -1;  // The box's paging row, or -1 if every message fits
 
 Calling_Station Answer_CQ[100];
 CQ_Station Calling_CQ[8];
@@ -79,6 +99,8 @@ int message_limit = DISPLAY_DECODED_LINES;
 int max_Calling_Stations = DISPLAY_DECODED_LINES;
 int num_Calling_Stations;
 
+static DecodeStats decode_stats;  // What the last decode of a timeslot did
+
 // extern char Station_Call[];
 
 extern float Station_Latitude, Station_Longitude;
@@ -99,149 +121,676 @@ extern int log_flag, logging_on;
 static Sequencer& seq = Sequencer::getSequencer();
 
 /**
- *  Retrieve address of the new_decoded[] messages
+ * @brief Cursor to the first message the last ft8_decode() decoded
+ * @return Pointer to the message in the decode arena, or NULL if none
  *
+ * Messages are iterated in place:  for (Decode* msg = firstDecoded(); msg != NULL; msg = nextDecoded(msg))
+ **/
+Decode* firstDecoded(void) {
+    return (num_decodes > 0) ? &decodes[0] : NULL;
+}
+
+/**
+ * @brief Advance a cursor into the decode arena
+ * @param msg A message returned by firstDecoded() or nextDecoded()
+ * @return The following message, or NULL after the last
+ **/
+Decode* nextDecoded(const Decode* msg) {
+    int index = decodedIndex(msg) + 1;
+    return (index > 0 && index < num_decodes) ? &decodes[index] : NULL;
+}
+
+/**
+ * @brief Position of a message in the decode arena
+ * @param msg A message returned by firstDecoded() or nextDecoded()
+ * @return Its index, 0 for the first decoded, or -1 if msg isn't in the arena
+ **/
+int decodedIndex(const Decode* msg) {
+    if (msg < &decodes[0] || msg >= &decodes[num_decodes]) return -1;
+    return msg - &decodes[0];
+}
+
+/**
+ * @brief Copy what the decoder did in the last timeslot
+ * @param stats Receives the statistics
+ **/
+void getDecodeStats(DecodeStats* stats) {
+    *stats = decode_stats;
+}
+
+/**
+ * @brief Number of messages the last ft8_decode() decoded
+ **/
+int getNumDecoded(void) {
+    return num_decodes;
+}
+
+/**
+ * @brief The decoded message displayed in a row of the Decoded Messages box
+ * @param row The box's item index
+ * @return Pointer to the message in the decode arena, or NULL if the row is empty
+ **/
+Decode* getDisplayedDecode(int row) {
+    if (row < 0 || row >= num_displayed_decodes) return NULL;
+    return &decodes[displayed_decodes[row]];
+}
+
+// A candidate's audio frequency in Hz
+static float candidate_freq_hz(const Candidate& cand) {
+    const float fsk_dev = 6.25f;  // tone deviation in Hz and symbol rate
+    return (cand.freq_offset + cand.freq_sub / 2.0f) * fsk_dev;
+}
+
+/**
+ * Run the LDPC decoder selected by LDPC_MIN_SUM and LDPC_LAYERED
+ *
+ * @param log174 The candidate's bit likelihoods
+ * @param plain Receives the decoded codeword's N bits
+ * @param n_errors Receives the number of parity checks left unsatisfied
+ * @return Number of iterations the decoder ran
+ **/
+static int ldpc_decode_candidate(float log174[], uint8_t plain[], int* n_errors) {
+    // bp_decode() produces better decodes, uses way less memory
+    int iterations;
+#if LDPC_MIN_SUM
+    int8_t llr[N];
+    quantize_likelihood(log174, llr);
+    ms_decode(llr, kLDPC_iterations, plain, n_errors, &iterations);
+#elif LDPC_LAYERED
+    bp_decode_layered(log174, kLDPC_iterations, plain, n_errors, &iterations);
+#else
+    bp_decode(log174, kLDPC_iterations, plain, n_errors, &iterations);
+#endif
+    return iterations;
+}  // ldpc_decode_candidate()
+
+// Candidates decoded per LDPC call:  bp_decode_batch()'s lanes with LDPC_BATCH, otherwise one at a time
+#if LDPC_BATCH && !LDPC_MIN_SUM && !LDPC_LAYERED
+const int kLDPC_group = kLDPC_lanes;
+#else
+const int kLDPC_group = 1;
+#endif
+
+/**
+ * LDPC decode a group of up to kLDPC_group candidates
  *
+ * @param log174 The candidates' bit likelihoods
+ * @param group Number of candidates
+ * @param plain Receives each candidate's decoded codeword
+ * @param n_errors Receives each candidate's number of unsatisfied parity checks
+ * @return Total number of iterations the decoder ran
  **/
-Decode* getNewDecoded() {
-    return new_decoded;
+static int ldpc_decode_group(float log174[][174], int group, uint8_t plain[][174], int n_errors[]) {
+    int iterations = 0;
+#if LDPC_BATCH && !LDPC_MIN_SUM && !LDPC_LAYERED
+    LDPCBatch batch;
+    batch.num_lanes = group;
+    for (int g = 0; g < group; ++g) batch.codeword[g] = log174[g];
+    bp_decode_batch(batch, kLDPC_iterations);
+    for (int g = 0; g < group; ++g) {
+        memcpy(plain[g], batch.plain[g], N);
+        n_errors[g] = batch.ok[g];
+        iterations += batch.iterations[g];
+    }
+#else
+    for (int g = 0; g < group; ++g) iterations += ldpc_decode_candidate(log174[g], plain[g], &n_errors[g]);
+#endif
+    return iterations;
+}  // ldpc_decode_group()
+
+/**
+ * The millis() time at which the timeslot ft8_decode() is about to decode received its last symbol
+ *
+ * @param now millis() when ft8_decode() began
+ * @return millis() at the end of the timeslot's ft8_msg_samples symbols
+ *
+ * Decoding normally begins at that moment, a little before the next timeslot begins, but a
+ * decode held up (e.g. by the display) may begin after it.  Either way, the timeslot under
+ * decode is the one whose end lies nearest to now.
+ **/
+static uint32_t acquisition_end(uint32_t now) {
+    const int32_t kAcquired_ms = ft8_msg_samples * 160;  // 160 mS per symbol
+    int32_t into = (int32_t)((now - start_time) % 15000);
+    int32_t late_ms = (into >= kAcquired_ms / 2) ? into - kAcquired_ms : into + 15000 - kAcquired_ms;
+    return now - late_ms;
+}  // acquisition_end()
+
+/**
+ * Whether a decoding stage expected to take expected_us finishes by the deadline
+ *
+ * @param deadline millis() by which ft8_decode() must finish
+ * @param expected_us The stage's cost estimate (see update_cost())
+ **/
+static bool fits_before(uint32_t deadline, uint32_t expected_us) {
+    return (int32_t)(deadline - millis()) >= (int32_t)((expected_us + 999) / 1000);
+}
+
+// A stage's cost estimate is the worst it has recently cost:  each run's cost raises it, and it relaxes by 1/8 per run
+static void update_cost(uint32_t& cost_us, uint32_t measured_us) {
+    cost_us -= cost_us / 8;
+    if (measured_us > cost_us) cost_us = measured_us;
 }
 
+static uint32_t group_cost_us = 0;  // Recent cost of a group's likelihoods and LDPC decoding
+
 /**
- * Decode received->FT8 signals into new_decoded[] of successfully decoded messages (if any)
+ * Pack the callsigns of the message we expect from our QSO partner
  *
- * @return Number of successfully demodulated messages placed in new_decoded[]
+ * @param a77 Receives the packed callsigns (see apply_apriori_callsigns())
+ * @return true if the Sequencer is listening for the partner's reply
+ **/
+static bool expected_callsigns(uint8_t a77[]) {
+    switch (seq.getState()) {
+        case LISTEN_RSL:   // Their RSL for us
+        case LISTEN_RRSL:  // Their roger and RSL for us
+        case LISTEN_RRR:   // Their RRR/RR73/73
+        case LISTEN_73:    // Their 73
+            break;
+        default:
+            return false;
+    }
+    if (Target_Call[0] == 0) return false;
+    return pack_callsigns(thisStation.getCallsign(), Target_Call, a77) == 0;
+}  // expected_callsigns()
+
+/**
+ * Pack a decoded codeword's payload and check its CRC
  *
- * new_decoded[] can hold a hard-wired maximum of 20 messages.
+ * @param plain The codeword's N bits from the LDPC decoder or osd_decode()
+ * @param a91 Receives the packed payload, its CRC bits cleared
+ * @return true if the CRC matches
  **/
-int ft8_decode(void) {
-    // DTRACE();
+static bool check_crc(const uint8_t plain[], uint8_t a91[]) {
+    // Extract payload + CRC (first K bits)
+    pack_bits(plain, K, a91);  // Pack K bits into a91[] from K bool bytes in plain[]
+
+    // Extract CRC and verify it with the computed CRC
+    uint16_t chksum = ((a91[9] & 0x07) << 11) | (a91[10] << 3) | (a91[11] >> 5);  // Extracted CRC from transmitted message
+    a91[9] &= 0xF8;
+    a91[10] = 0;
+    a91[11] = 0;
+    uint16_t chksum2 = crc(a91, 96 - 14);  // Computed CRC for message as actually received
+    return chksum == chksum2;              // Skip messages whose CRCs don't match
+}  // check_crc()
+
+// A decoded message's payload and the candidate it was decoded from, enough to re-synthesise its signal
+struct DecodedSignal {
+    uint8_t a91[12];  // [K_BYTES]
+    Candidate cand;
+};
+
+// The timeslot's distinct payloads, for subtract_decoded() and to drop their signals' other candidates
+static DecodedSignal decoded_signals[kPayload_set_limit];
+static int num_decoded_signals;
+static PayloadSet decoded_payloads;  // The same payloads, for rejecting repeats before unpacking them
+static uint32_t decodes_acquired;    // acquisition_end() of the timeslot the decode arena holds
+static bool early_pass_active;       // ft8_decode_early() is running, so the timeslot is still being received
+
+/**
+ * Empty the decode arena for a new timeslot's messages
+ *
+ * @param acquired acquisition_end() of the timeslot
+ *
+ * The Decoded Messages box is emptied too:  its rows map to arena entries that this timeslot's
+ * messages overwrite, so touching one until display_messages() redraws the box would select the
+ * wrong station.
+ **/
+static void clear_decodes(uint32_t acquired) {
+    ui.allDecodedMsgs->reset();
+    num_displayed_decodes = 0;
+    display_paging_row = -1;
+    num_decodes = 0;
+    num_decoded_signals = 0;
+    payload_set_clear(decoded_payloads);
+    decodes_acquired = acquired;
+    decode_stats.duplicates_rejected = 0;
+    decode_stats.early_decodes = 0;
+}
 
-    // Find top candidates by Costas sync score and localize them in time and frequency
-    Candidate candidate_list[kMax_candidates];
-    int num_candidates = find_sync(export_fft_power, ft8_msg_samples, ft8_buffer, kCostas_map, kMax_candidates, candidate_list, kMin_score);
-    char decoded[kMax_decoded_messages][kMax_message_length];
+/**
+ * Record a payload whose CRC matched in the decode arena and tell the Sequencer about it
+ *
+ * @param a91 The payload from check_crc()
+ * @param cand The candidate the payload was decoded from
+ * @param decoded The payloads already decoded this timeslot, for rejecting duplicates before unpacking them
+ * @return true if the message was recorded
+ **/
+static bool record_payload(const uint8_t a91[], const Candidate& cand, PayloadSet& decoded) {
+    float freq_hz = candidate_freq_hz(cand);
 
-    const float fsk_dev = 6.25f;  // tone deviation in Hz and symbol rate
+    // Have we previously decoded this message?  Repeats skip unpacking, the hashed callsign table and the Sequencer.
+    if (!payload_set_insert(decoded, a91)) {
+        ++decode_stats.duplicates_rejected;
+        return false;
+    }
+    memcpy(decoded_signals[num_decoded_signals].a91, a91, sizeof(decoded_signals[num_decoded_signals].a91));
+    decoded_signals[num_decoded_signals++].cand = cand;
+
+    // We have finally decoded the FT8 message bits and verified a valid CRC.  The message looks good.
+    // Now we can unpack the FT8 encoding (see reference) into human-readable fields.
+    char field1[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE];  // Free text msg can be 13 chars + NUL terminator
+    char field2[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE];  // bracket + 11 + bracket + NUL terminator
+    char field3[FTX_REPORTS_BFRSIZE];                         // 6 + NUL terminator
+    MsgType msgType;
+    // ftx_message_offsets_t offsets[3];
+    int rc = unpack77_fields(a91, field1, field2, field3, &msgType);
+    if (rc < 0) return false;  // Unpack failure???
+
+    // DPRINTF("field1='%s', field2='%s', field3='%s', msgType=%u\n", field1, field2, field3, msgType);
+
+    int raw_RSL;
+    int display_RSL;
+    float distance;
+
+    getTeensy3Time();
+    char rtc_string[10];  // print format stuff
+    snprintf(rtc_string, sizeof(rtc_string), "%02i:%02i:%02i", hour(), minute(), second());
+
+    if (num_decodes < kMax_decodes) {
+        // The message's text, "field1 field2 field3 ", must fit a kMax_message_length display line
+        if (strlen(field1) + strlen(field2) + strlen(field3) + 3 < (size_t)kMax_message_length) {
+            Decode& msg = decodes[num_decodes];
+            msg.sync_score = cand.score;
+            msg.freq_hz = (int)freq_hz;
+            strlcpy(msg.field1, field1, 14);  // Destination station
+            strlcpy(msg.field2, field2, 14);  // Source station
+            strlcpy(msg.field3, field3, 7);   // Extra info passed to destination from source
+            strlcpy(msg.decode_time, rtc_string, 10);
+
+            raw_RSL = msg.sync_score;
+            if (raw_RSL > 160) raw_RSL = 160;
+            display_RSL = (raw_RSL - 160) / 6;
+            msg.snr = display_RSL;  // Their received signal level at our station
+            msg.msgType = msgType;  // Record the msgType
+
+            char Target_Locator[] = "    ";
+
+            // Assume field3 is a locator
+            strlcpy(Target_Locator, msg.field3, sizeof(Target_Locator));
+
+            // Try to determine if field3 is really a locator (Note:  msgType is the preferred indicator *except* for CQ)
+            if (validate_locator(Target_Locator) == 1) {
+                distance = Target_Distance(Target_Locator);
+                msg.distance = (int)distance;
+                strlcpy(msg.locator, Target_Locator, 7);  // Bug:  Save their perhaps-this-is-a-locator for logging
+            } else {
+                msg.distance = 0;    // We don't know distance to target
+                msg.locator[0] = 0;  // We don't have a valid locator for target
+            }
+
+            // Inform QSO sequencer about newly received message
+            msg.sequenceNumber = seq.getSequenceNumber();
+            num_decodes++;
+            seq.receivedMsgEvent(&msg);
+            return true;
+        }
+    }
+    return false;
+}  // record_payload()
+
+/**
+ * Check the CRC of a decoded codeword and record its message in the decode arena
+ *
+ * @param plain The codeword's N bits from the LDPC decoder or osd_decode()
+ * @param cand The candidate the codeword was decoded from
+ * @param decoded The payloads already decoded this timeslot, for rejecting duplicates before unpacking them
+ * @return true if the message was recorded
+ **/
+static bool record_message(const uint8_t plain[], const Candidate& cand, PayloadSet& decoded) {
+    uint8_t a91[K_BYTES];  // Bfr for the received message's packed bits
+    return check_crc(plain, a91) && record_payload(a91, cand, decoded);
+}  // record_message()
+
+// Whether two candidates are peaks of the same signal, within +/-1 step as suppress_candidates() judges them
+static bool same_signal(const Candidate& a, const Candidate& b) {
+    int dt = (2 * a.time_offset + a.time_sub) - (2 * b.time_offset + b.time_sub);
+    int df = (2 * a.freq_offset + a.freq_sub) - (2 * b.freq_offset + b.freq_sub);
+    return dt >= -2 && dt <= 2 && df >= -2 && df <= 2;
+}
+
+// Whether a candidate is a peak of a signal already decoded this timeslot
+static bool already_decoded(const Candidate& cand) {
+    for (int i = 0; i < num_decoded_signals; ++i) {
+        if (same_signal(cand, decoded_signals[i].cand)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Whether ft8_decode_early() is running
+ *
+ * The timeslot is still being received, so the Sequencer must not key the transmitter yet:  loop()
+ * keys it once ft8_decode() has finished the timeslot (see Sequencer::actionPendXmit()).
+ **/
+bool decoding_early(void) {
+    return early_pass_active;
+}
+
+/**
+ * Decode the strongest signals from the first config.earlyDecode symbols of the timeslot being acquired
+ *
+ * Called by loop() once process_FT8_FFT() has transformed config.earlyDecode symbols, this early
+ * pass works from the spectrogram bank extract_power() is still filling, reading only the rows
+ * already transformed.  find_sync() bounded by those rows finds the signals whose data symbols
+ * have arrived, less up to kMax_erased_symbols which extract_likelihood() erases, and their
+ * codewords are LDPC decoded, strongest first, until the timeslot's last symbol arrives.
+ *
+ * Messages whose CRCs match start the timeslot's decode arena and reach the Sequencer at once, so
+ * loop() can display them and RoboOp can prepare its reply before the timeslot ends.  ft8_decode()
+ * keeps them, decodes only the candidates they don't account for, and leaves near misses to its
+ * a priori reruns and OSD.
+ **/
+void ft8_decode_early(void) {
+    uint32_t early_start = millis();
+    uint32_t acquired = acquisition_end(early_start);
+    int num_blocks = FT_8_counter;
+    if (num_blocks >= ft8_msg_samples) return;  // Too late, ft8_decode() will handle the whole timeslot
+#if SPECTROGRAM_4BIT
+    const PackedRow* power = (const PackedRow*)export_fft_power;
+#else
+    const uint8_t* power = export_fft_power;
+#endif
+    clear_decodes(acquired);
+    early_pass_active = true;
+
+    Candidate candidate_list[kCandidate_pool];
+    int num_candidates = find_sync(power, num_blocks, ft8_buffer, kCostas_map, kCandidate_pool, candidate_list, kMin_score, (SyncSearch)config.syncSearch,
+                                   kMax_erased_symbols);
+    int runs_saved;
+    num_candidates = suppress_candidates(candidate_list, num_candidates, kMax_candidates, &runs_saved);
+
+    for (int first = 0; first < num_candidates; first += kLDPC_group) {
+        service_audio();  // Keep acquiring the rest of the timeslot
+        if (!fits_before(acquired, group_cost_us)) break;
+
+        int group = (num_candidates - first < kLDPC_group) ? num_candidates - first : kLDPC_group;
+        float log174[kLDPC_group][174];  // [N]
+        uint8_t plain[kLDPC_group][174];
+        int n_errors[kLDPC_group];
+        uint32_t group_start = micros();
+        for (int g = 0; g < group; ++g) extract_likelihood(power, ft8_buffer, candidate_list[first + g], kGray_map, log174[g], num_blocks);
+        ldpc_decode_group(log174, group, plain, n_errors);
+        update_cost(group_cost_us, micros() - group_start);
+
+        for (int g = 0; g < group; ++g) {
+            if (n_errors[g] == 0 && record_message(plain[g], candidate_list[first + g], decoded_payloads)) ++decode_stats.early_decodes;
+        }
+    }
+    early_pass_active = false;
+}  // ft8_decode_early()
+
+/**
+ * Subtract the signals of decoded_signals[first..num_decoded_signals) from the timeslot's spectrogram
+ *
+ * @param bank The spectrogram bank from decode_spectrogram()
+ * @param first Index of the first decoded signal not yet subtracted
+ *
+ * Each payload's 79 tones are re-synthesised by genft8() and subtract_signal() removes their
+ * estimated power at the candidate's time and frequency, so the next pass's find_sync() finds
+ * the weaker signals they masked rather than the decoded signals again.
+ **/
+static void subtract_decoded(const uint8_t* bank, int first) {
+    // The decoder owns its bank until release_spectrogram(), and no other pass reads it
+#if SPECTROGRAM_4BIT
+    PackedRow* power = (PackedRow*)bank;
+#else
+    uint8_t* power = (uint8_t*)bank;
+#endif
+    for (int i = first; i < num_decoded_signals; ++i) {
+        uint8_t tones[79];  // [NN]
+        genft8(decoded_signals[i].a91, tones);
+        subtract_signal(power, ft8_msg_samples, ft8_buffer, decoded_signals[i].cand, tones);
+    }
+}  // subtract_decoded()
 
+/**
+ * Decode received->FT8 signals into the decode arena of successfully decoded messages (if any)
+ *
+ * @return Number of successfully demodulated messages placed in the arena
+ *
+ * The arena holds kMax_decodes messages (FT8_MAX_DECODES), however many the display shows.
+ *
+ * ft8_decode() works from the spectrogram bank handed off by process_FT8_FFT() and calls
+ * service_audio() between candidates so the following timeslot's audio is transformed into
+ * the other bank rather than stalling in the audio queue.
+ *
+ * So RoboOp may reply in the next timeslot, decoding must finish config.decodeBudgetMs after
+ * the timeslot's last symbol.  Candidates are decoded strongest sync score first, and before
+ * each LDPC group, a priori rerun and OSD attempt, ft8_decode() compares that stage's recent
+ * cost with the time remaining and stops short of the deadline rather than overrun it.  The
+ * strongest group is decoded regardless, so a late start still yields the loudest signals.
+ *
+ * Messages the early pass (see ft8_decode_early()) decoded from this timeslot are already in the
+ * arena and have reached the Sequencer.  ft8_decode() keeps them, doesn't decode the candidates that
+ * are peaks of their signals again, and rejects repeats of their payloads before unpacking them.
+ *
+ * With config.sicPasses above 1, successive interference cancellation follows:  the signals
+ * decoded so far are subtracted from the spectrogram (see subtract_decoded()) and find_sync()
+ * searches what remains for the weaker signals they masked.  Each later pass runs only if the
+ * last decoded something new and its find_sync() recently fit before the deadline, and
+ * decode_stats.sic_pass_decodes[] reports what each pass found.  The near misses of all passes go to OSD last.
+ **/
+int ft8_decode(void) {
     // DTRACE();
 
-    // Go over candidates and attempt to decode their messages
-    int num_decoded = 0;
+    uint32_t decode_start = millis();
+    uint32_t acquired = acquisition_end(decode_start);
+    uint32_t deadline = acquired + ((config.decodeBudgetMs > 0) ? config.decodeBudgetMs : 15000);
+    static uint32_t ap_cost_us = 0;  // Recent cost of an a priori rerun
+    static uint32_t osd_cost_us = kOSD_first_cost_us;
+    static uint32_t sic_cost_us = 0;  // Recent cost of subtracting a pass's signals and searching again
+    int passes = ((int)config.sicPasses < 1) ? 1 : (((int)config.sicPasses > kMax_sic_passes) ? kMax_sic_passes : (int)config.sicPasses);
+    decode_stats.candidates_skipped = 0;
+    decode_stats.ap_skipped = 0;
+    decode_stats.osd_skipped = 0;
+
+    // Take the timeslot's spectrogram from the acquisition side
+    const uint8_t* bank = decode_spectrogram();
+    if (bank == NULL) return 0;
+#if SPECTROGRAM_4BIT
+    const PackedRow* power = (const PackedRow*)bank;
+#else
+    const uint8_t* power = bank;
+#endif
+
+    // Go over candidates and attempt to decode their messages, after those the early pass recorded
+    int32_t arena_gap_ms = (int32_t)(acquired - decodes_acquired);
+    if (arena_gap_ms <= -7500 || arena_gap_ms >= 7500) clear_decodes(acquired);  // The arena holds another timeslot's
+    decode_stats.early_runs_saved = 0;
+    decode_stats.ldpc_iterations = 0;
+    for (int pass = 0; pass < kMax_sic_passes; ++pass) decode_stats.sic_pass_decodes[pass] = 0;
+    decode_stats.sic_us = 0;
+
+    // While we await our QSO partner's reply, we already know both of its callsigns
+    uint8_t ap_a77[K_BYTES];
+    bool ap_active = expected_callsigns(ap_a77);
+    int ap_freq_hz = seq.getWorkedFreq();
+    decode_stats.ap_runs = 0;
+    decode_stats.ap_decodes = 0;
+    decode_stats.ap_rejected = 0;
+
+    // The LDPC decoder's closest failures, fewest unsatisfied parity checks first, for osd_decode()
+    struct NearMiss {
+        Candidate cand;
+        int n_errors;
+        float log174[174];  // [N]
+    } near_misses[kOSD_max_candidates];
+    int num_near_misses = 0;
+
+    // DTRACE();
 
     // DPRINTF("num_candidates=%u\n", num_candidates);
 
-    for (int idx = 0; idx < num_candidates; ++idx) {
-        Candidate cand = candidate_list[idx];
-        float freq_hz = (cand.freq_offset + cand.freq_sub / 2.0f) * fsk_dev;
+    int subtracted = 0;  // decoded_signals[] already subtracted from the spectrogram
+    for (int pass = 0; pass < passes; ++pass) {
+        uint32_t pass_start = micros();
+        int pass_start_decodes = num_decodes;
+        if (pass > 0) {
+            // Stop once a pass decodes nothing new, or before a pass that wouldn't fit
+            service_audio();
+            if (subtracted == num_decoded_signals || !fits_before(deadline, sic_cost_us)) break;
+            subtract_decoded(bank, subtracted);
+            subtracted = num_decoded_signals;
+        }
 
-        float log174[N];
-        extract_likelihood(export_fft_power, ft8_buffer, cand, kGray_map, log174);
+        // Find top candidates by Costas sync score and localize them in time and frequency
+        Candidate candidate_list[kCandidate_pool];
+        int num_candidates = find_sync(power, ft8_msg_samples, ft8_buffer, kCostas_map, kCandidate_pool, candidate_list, kMin_score, (SyncSearch)config.syncSearch);
+
+        // Merge peaks of the same signal so the LDPC decoder's kMax_candidates runs go to distinct signals, strongest first
+        int runs_saved;
+        num_candidates = suppress_candidates(candidate_list, num_candidates, kMax_candidates, &runs_saved);
+
+        // Drop the signals already decoded, by the early pass or, after their subtraction, whatever survived of them
+        int num_new = 0;
+        for (int c = 0; c < num_candidates; ++c) {
+            if (!already_decoded(candidate_list[c])) {
+                candidate_list[num_new++] = candidate_list[c];
+            } else if (pass == 0) {
+                ++decode_stats.early_runs_saved;
+            } else {
+                ++runs_saved;
+            }
+        }
+        num_candidates = num_new;
+        decode_stats.ldpc_runs_saved = (pass == 0) ? runs_saved : decode_stats.ldpc_runs_saved + runs_saved;
+        if (pass > 0) update_cost(sic_cost_us, micros() - pass_start);
 
-        // bp_decode() produces better decodes, uses way less memory
-        uint8_t plain[N];
-        int n_errors = 0;
-        bp_decode(log174, kLDPC_iterations, plain, &n_errors);
-        // DPRINTF("candidate %d n_errors=%d\n", idx, n_errors);
-
-        if (n_errors > 0) continue;  // Skip messages that can't be decoded
-
-        // Extract payload + CRC (first K bits)
-        uint8_t a91[K_BYTES];      // Bfr for the received message's packed bits
-        pack_bits(plain, K, a91);  // Pack K bits into a91[] from K bool bytes in plain[]
-
-        // Extract CRC and verify it with the computed CRC
-        uint16_t chksum = ((a91[9] & 0x07) << 11) | (a91[10] << 3) | (a91[11] >> 5);  // Extracted CRC from transmitted message
-        a91[9] &= 0xF8;
-        a91[10] = 0;
-        a91[11] = 0;
-        uint16_t chksum2 = crc(a91, 96 - 14);  // Computed CRC for message as actually received
-        if (chksum != chksum2) continue;       // Skip messages whose CRCs don't match
-
-        // We have finally decoded the FT8 message bits and verified a valid CRC.  The message looks good.
-        // Now we can unpack the FT8 encoding (see reference) into human-readable fields.
-        char message[FTX_MAX_MESSAGE_LENGTH];                     // 13 + space + 13 + space + 6 + NUL terminator
-        char field1[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE];  // Free text msg can be 13 chars + NUL terminator
-        char field2[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE];  // bracket + 11 + bracket + NUL terminator
-        char field3[FTX_REPORTS_BFRSIZE];                         // 6 + NUL terminator
-        MsgType msgType;
-        // ftx_message_offsets_t offsets[3];
-        int rc = unpack77_fields(a91, field1, field2, field3, &msgType);
-        if (rc < 0) continue;  // Unpack failure???
-
-        snprintf(message, sizeof(message), "%s %s %s ", field1, field2, field3);  // Duplicate decodes appear possible???
-        // DPRINTF("message='%s', msgType=%u\n", message, msgType);
-
-        // Have we previously decoded this message?  TODO:  We could use the new ft8_lib's hashed messages.
-        bool duplicateMessage = false;
-        for (int i = 0; i < num_decoded; ++i) {
-            if (0 == strcmp(decoded[i], message)) {
-                duplicateMessage = true;
+        for (int first = 0; first < num_candidates; first += kLDPC_group) {
+            service_audio();  // Keep acquiring the next timeslot while we decode this one
+
+            // The remaining candidates are weaker than those decoded so far, so leave them all at the deadline
+            if (first > 0 && !fits_before(deadline, group_cost_us)) {
+                decode_stats.candidates_skipped += num_candidates - first;
                 break;
             }
-        }
 
-        int raw_RSL;
-        int display_RSL;
-        float distance;
-
-        getTeensy3Time();
-        char rtc_string[10];  // print format stuff
-        snprintf(rtc_string, sizeof(rtc_string), "%02i:%02i:%02i", hour(), minute(), second());
-
-        // Skip duplicaates
-        if (!duplicateMessage && num_decoded < kMax_decoded_messages) {
-            if (strlen(message) < kMax_message_length) {
-                strlcpy(decoded[num_decoded], message, kMax_message_length);
-
-                new_decoded[num_decoded].sync_score = cand.score;
-                new_decoded[num_decoded].freq_hz = (int)freq_hz;
-                strlcpy(new_decoded[num_decoded].field1, field1, 14);  // Destination station
-                strlcpy(new_decoded[num_decoded].field2, field2, 14);  // Source station
-                strlcpy(new_decoded[num_decoded].field3, field3, 7);   // Extra info passed to destination from source
-                strlcpy(new_decoded[num_decoded].decode_time, rtc_string, 10);
-
-                raw_RSL = new_decoded[num_decoded].sync_score;
-                if (raw_RSL > 160) raw_RSL = 160;
-                display_RSL = (raw_RSL - 160) / 6;
-                new_decoded[num_decoded].snr = display_RSL;  // Their received signal level at our station
-                new_decoded[num_decoded].msgType = msgType;  // Record the msgType
-
-                char Target_Locator[] = "    ";
-
-                // Assume field3 is a locator
-                strlcpy(Target_Locator, new_decoded[num_decoded].field3, sizeof(Target_Locator));
-
-                // Try to determine if field3 is really a locator (Note:  msgType is the preferred indicator *except* for CQ)
-                if (validate_locator(Target_Locator) == 1) {
-                    distance = Target_Distance(Target_Locator);
-                    new_decoded[num_decoded].distance = (int)distance;
-                    strlcpy(new_decoded[num_decoded].locator, Target_Locator, 7);  // Bug:  Save their perhaps-this-is-a-locator for logging
-                } else {
-                    new_decoded[num_decoded].distance = 0;    // We don't know distance to target
-                    new_decoded[num_decoded].locator[0] = 0;  // We don't have a valid locator for target
+            int group = (num_candidates - first < kLDPC_group) ? num_candidates - first : kLDPC_group;
+            float log174[kLDPC_group][174];  // [N]
+            uint8_t plain[kLDPC_group][174];
+            int n_errors[kLDPC_group];
+            uint32_t group_start = micros();
+            for (int g = 0; g < group; ++g) extract_likelihood(power, ft8_buffer, candidate_list[first + g], kGray_map, log174[g]);
+            decode_stats.ldpc_iterations += ldpc_decode_group(log174, group, plain, n_errors);
+            update_cost(group_cost_us, micros() - group_start);
+
+            for (int g = 0; g < group; ++g) {
+                Candidate cand = candidate_list[first + g];
+                // DPRINTF("candidate %d n_errors=%d\n", first + g, n_errors[g]);
+
+                // Near our QSO partner's frequency, try again knowing the callsigns of the message we expect
+                if (n_errors[g] > 0 && ap_active && decode_stats.ap_runs < kAP_max_candidates && abs((int)candidate_freq_hz(cand) - ap_freq_hz) <= kAP_freq_span) {
+                    if (!fits_before(deadline, ap_cost_us)) {
+                        ++decode_stats.ap_skipped;
+                    } else {
+                        float ap174[N];
+                        memcpy(ap174, log174[g], sizeof(ap174));
+                        apply_apriori_callsigns(ap174, ap_a77);
+                        int ap_errors = 0;
+                        uint32_t ap_start = micros();
+                        decode_stats.ldpc_iterations += ldpc_decode_candidate(ap174, plain[g], &ap_errors);
+                        update_cost(ap_cost_us, micros() - ap_start);
+                        ++decode_stats.ap_runs;
+                        // Report it as their reply only if it really carries both of the callsigns we forced
+                        uint8_t a91[K_BYTES];
+                        if (ap_errors == 0 && check_crc(plain[g], a91)) {
+                            if (!callsigns_match(a91, thisStation.getCallsign(), Target_Call)) {
+                                ++decode_stats.ap_rejected;
+                            } else if (record_payload(a91, cand, decoded_payloads)) {
+                                ++decode_stats.ap_decodes;
+                                continue;
+                            }
+                        }
+                    }
+                }
+
+                if (n_errors[g] > 0) {
+                    // Skip messages that can't be decoded, but remember the nearest misses
+                    if (n_errors[g] > kOSD_max_errors) continue;
+                    int slot = num_near_misses;
+                    if (slot == kOSD_max_candidates) {
+                        if (n_errors[g] >= near_misses[slot - 1].n_errors) continue;
+                        --slot;  // Replace the worst
+                    } else {
+                        ++num_near_misses;
+                    }
+                    for (; slot > 0 && near_misses[slot - 1].n_errors > n_errors[g]; --slot) near_misses[slot] = near_misses[slot - 1];
+                    near_misses[slot].cand = cand;
+                    near_misses[slot].n_errors = n_errors[g];
+                    memcpy(near_misses[slot].log174, log174[g], sizeof(near_misses[slot].log174));
+                    continue;
                 }
 
-                // Inform QSO sequencer about newly received message
-                new_decoded[num_decoded].sequenceNumber = seq.getSequenceNumber();
-                seq.receivedMsgEvent(&new_decoded[num_decoded]);
-                ++num_decoded;
+                record_message(plain[g], cand, decoded_payloads);
             }
+        }  // End of big decode loop
+
+        decode_stats.sic_pass_decodes[pass] = num_decodes - pass_start_decodes;
+        if (pass == 0) {
+            decode_stats.sic_pass_decodes[0] += decode_stats.early_decodes;
+        } else {
+            decode_stats.sic_us += micros() - pass_start;
+        }
+    }  // End of passes
+
+    // Try the near misses by ordered statistics while there's time before the deadline
+    decode_stats.osd_runs = 0;
+    decode_stats.osd_decodes = 0;
+    decode_stats.osd_max_us = 0;
+    for (int i = 0; i < num_near_misses && num_decodes < kMax_decodes; ++i) {
+        if (already_decoded(near_misses[i].cand)) continue;  // A later pass decoded it after all
+        service_audio();
+        if (!fits_before(deadline, osd_cost_us)) {
+            decode_stats.osd_skipped = num_near_misses - i;
+            break;
+        }
+
+        uint8_t plain[N];
+        uint32_t osd_start = micros();
+        bool ok = osd_decode(near_misses[i].log174, kOSD_order, plain);
+        uint32_t osd_us = micros() - osd_start;
+        ++decode_stats.osd_runs;
+        if (osd_us > decode_stats.osd_max_us) decode_stats.osd_max_us = osd_us;
+        update_cost(osd_cost_us, osd_us);
+
+        if (ok && record_message(plain, near_misses[i].cand, decoded_payloads)) {
+            ++decode_stats.osd_decodes;
         }
-    }  // End of big decode loop
+    }
 
-    return num_decoded;
+    release_spectrogram(bank);  // Return the bank to extract_power()
+
+    // Account for the deadline:  find_sync() and the strongest group aren't scheduled, and estimates may fall short
+    uint32_t finish = millis();
+    decode_stats.decode_ms = (int32_t)(finish - acquired);
+    int32_t overrun_ms = (int32_t)(finish - deadline);
+    if (overrun_ms > 0) {
+        ++decode_stats.decode_overruns;
+        if (overrun_ms > decode_stats.max_overrun_ms) decode_stats.max_overrun_ms = overrun_ms;
+    }
+    return num_decodes;
 
 }  // ft8_decode()
 
+static void display_page(void);
+
+// Whether the Decoded Messages box shows a message:  those not sent to our station, except unknown and
+// telemetry whose content remain a mystery
+static bool displayable(const Decode* msg) {
+    if (strncmp(msg->field1, thisStation.getCallsign(), 14) == 0) return false;
+    return msg->msgType != MSG_UNKNOWN && msg->msgType != MSG_TELE;
+}
+
 /**
  * Display decoded received messages, if any, on the LCD (left side)
  *
- * @param decoded_messages Number of successfully decoded messages in new_decoded[] array
+ * @param decoded_messages Number of successfully decoded messages in the decode arena
  *
  * The size of the LCD's message display region limits the maximum number of displayed
- * messages to message_limit=6.  When the number of decoded messages exceeds what can
- * be displayed, only the first message_limit messages appear.
+ * messages to message_limit.  That's a page of the decode arena, which may hold many more:
+ * when the displayable messages don't fit, the box's last row is a paging row and touching
+ * it shows the next page (see display_next_page()).  A new timeslot's messages start at the
+ * first page, and getDisplayedDecode() maps the box's rows back to the page's messages.
  *
  * The LCD display region is rectangular, 240 pixels wide and 140 pixels high.  Text size 2
  * produces 12X16 (widthXheight) pixel characters.
@@ -252,7 +801,6 @@ int ft8_decode(void) {
 static const unsigned lineHeight = TEXT2_LINE_HEIGHT;  // Height in pixels of one line of text (including leading)
 static int previousMessageCount = 0;                   // Number of messages displayed in previous timeslot
 void display_messages(int decoded_messages) {
-    char message[kMax_message_length];
     // char big_gulp[60];
 
     // Erase the message display region on the LCD.  It turns out that fillRect() of a large region is amazingly slow, increasing the
@@ -262,37 +810,87 @@ void display_messages(int decoded_messages) {
 
     // Display info about each decoded message.  field1 is receiving station's callsign or CQ, field2 is transmitting station's callsign,
     // field3 is an RSL or locator or ???.
-    if (decoded_messages > 0) ui.allDecodedMsgs->reset();               // Clear all the old messages
-    for (int i = 0; i < decoded_messages && i <= message_limit; i++) {  // Charlie's leading handled 6 rows of text
-        snprintf(message, sizeof(message), "%s %s %4s S%c", new_decoded[i].field1, new_decoded[i].field2, new_decoded[i].field3, rsl2s(new_decoded[i].snr));
-
-        // Display messages not sent to our station in the Decoded Messages box
-        if (strncmp(new_decoded[i].field1, thisStation.getCallsign(), 14) != 0) {
-            AColor color = A_LIGHT_GREY;                         // Chatter appears in light grey
-            if (strncmp(new_decoded[i].field1, "CQ", 2) == 0) {  // Check for received CQ
-                DTRACE();
-                color = A_WHITE;  // CQ messages appear in white
-            }
-            // Display received message except unknown and telemetry whose content remain a mystery
-            if (new_decoded[i].msgType != MSG_UNKNOWN && new_decoded[i].msgType != MSG_TELE) {
-                DTRACE();
-                ui.allDecodedMsgs->addItem(ui.allDecodedMsgs, message, color);  // Display usable received message
-            }
-        }
+    if (decoded_messages > 0) {
+        display_page_start = 0;  // A new timeslot's messages start at the first page
+        display_page();
     }
 
-    // Erase messages lines from the previous timeslot that weren't overwritten above
-    message[0] = 0;                           // An empty line
     previousMessageCount = decoded_messages;  // Remember for next timeslot
 
 }  // display_messages()
 
+/**
+ * Display the page of decoded messages starting at display_page_start in the Decoded Messages box
+ *
+ * The page shows up to message_limit displayable messages, or message_limit - 1 and a paging row
+ * when more follow or the page isn't the first.
+ **/
+static void display_page(void) {
+    char message[kMax_message_length];
+
+    ui.allDecodedMsgs->reset();  // Clear all the old messages
+    num_displayed_decodes = 0;
+    display_paging_row = -1;
+
+    // Count the displayable messages from the page's start to decide whether it needs a paging row
+    int remaining = 0;
+    for (int i = display_page_start; i < num_decodes; ++i) {
+        if (displayable(&decodes[i])) remaining++;
+    }
+    const bool paging = display_page_start > 0 || remaining > message_limit;
+    const int rows = paging ? message_limit - 1 : message_limit;
+
+    int index = display_page_start;
+    for (; index < num_decodes && num_displayed_decodes < rows; ++index) {
+        const Decode* msg = &decodes[index];
+        if (!displayable(msg)) continue;
+        snprintf(message, sizeof(message), "%s %s %4s S%c", msg->field1, msg->field2, msg->field3, rsl2s(msg->snr));
+
+        AColor color = A_LIGHT_GREY;               // Chatter appears in light grey
+        if (strncmp(msg->field1, "CQ", 2) == 0) {  // Check for received CQ
+            DTRACE();
+            color = A_WHITE;  // CQ messages appear in white
+        }
+        DTRACE();
+        if (ui.allDecodedMsgs->addItem(ui.allDecodedMsgs, message, color) == nullptr) return;  // Display usable received message
+        displayed_decodes[num_displayed_decodes++] = index;
+    }
+
+    // The paging row advances to the next page, or returns from the last page to the first
+    if (paging) {
+        const bool more = remaining > num_displayed_decodes;
+        display_next_page_start = more ? index : 0;
+        if (ui.allDecodedMsgs->addItem(ui.allDecodedMsgs, more ? "   -- more --" : "   -- first --", A_YELLOW) != nullptr) {
+            display_paging_row = num_displayed_decodes;
+        }
+    }
+}  // display_page()
+
+/**
+ * @brief The Decoded Messages box's paging row
+ * @return The row's item index, or -1 if the box shows every displayable message
+ **/
+int display_paging_row_index(void) {
+    return display_paging_row;
+}
+
+/**
+ * @brief Show the Decoded Messages box's next page of messages, or its first after the last
+ **/
+void display_next_page(void) {
+    if (display_paging_row < 0) return;
+    display_page_start = display_next_page_start;
+    display_page();
+}
+
 // Displays specified decoded message's callsign and signal strength
 void display_selected_call(int index) {
     char selected_station[FTX_MAX_MESSAGE_LENGTH];
     char blank[] = "        ";
-    strlcpy(Target_Call, new_decoded[index].field2, sizeof(Target_Call));
-    Target_RSL = new_decoded[index].snr;
+    Decode* msg = getDisplayedDecode(index);
+    if (msg == NULL) return;
+    strlcpy(Target_Call, msg->field2, sizeof(Target_Call));
+    Target_RSL = msg->snr;
     snprintf(selected_station, sizeof(selected_station), "%7s %3i", Target_Call, Target_RSL);
     // DPRINTF("display_selected_call(%d) '%s'\n", index, selected_station);
     tft.setTextColor(HX8357_YELLOW, HX8357_BLACK);
@@ -371,38 +969,36 @@ int strindex(const char s[], const char t[]) {
 /**
  * Displays decoded messages received from stations calling my station, if any, in right-side window
  *
- * @param num_decoded Number of entries in new_decoded[]
- *
- * @return -1 if no callers, else the index of last caller in new_decoded[]???
+ * @return -1 if no callers, else the index of last caller in the decode arena???
  *
  * This function checks every message addressed to our station, including messages that
  * address our station but are not "in" a QSO with us.  We display all messages addressed
  * to us (e.g. multiple replies to our CQ), but the logging package must determine what to log.
  *
- * @var new_decoded[] Array of successfully decoded messages (may or may not be addressed to us)
+ * The decode arena holds the successfully decoded messages (which may or may not be addressed to us).
  *
  **/
-int Check_Calling_Stations(int num_decoded) {
+int Check_Calling_Stations(void) {
     char big_gulp[60];
     char message[kMax_message_length];
     int message_test = 0;
 
-    // DPRINTF("%s(%d)\n", __FUNCTION__, num_decoded);
+    // DPRINTF("%s()\n", __FUNCTION__);
 
-    // Loop executed once for each entry in new_decoded[] of received messages
-    for (int i = 0; i < num_decoded; i++) {
+    // Loop executed once for each received message in the decode arena
+    for (Decode* msg = firstDecoded(); msg != NULL; msg = nextDecoded(msg)) {
         // Was this received message sent to our station?
-        if (strindex(new_decoded[i].field1, thisStation.getCallsign()) >= 0) {
+        if (strindex(msg->field1, thisStation.getCallsign()) >= 0) {
             // Yes, assemble details (their callsign, our callsign, extra_info) into message buffer
-            snprintf(message, sizeof(message), "%s %s %s", new_decoded[i].field1, new_decoded[i].field2, new_decoded[i].field3);
+            snprintf(message, sizeof(message), "%s %s %s", msg->field1, msg->field2, msg->field3);
 
             // Display details of received message addressed to our station
             getTeensy3Time();
-            snprintf(big_gulp, sizeof(message), "%02i/%02i/%4i %s %s", day(), month(), year(), new_decoded[i].decode_time, message);
+            snprintf(big_gulp, sizeof(message), "%02i/%02i/%4i %s %s", day(), month(), year(), msg->decode_time, message);
             // ui.theQSOMsgs->addItem(ui.theQSOMsgs, String(message));
 
             num_Calling_Stations++;
-            message_test = i + 100;  // 100+index of this calling station.  Why the 100 bias???
+            message_test = decodedIndex(msg) + 100;  // 100+index of this calling station.  Why the 100 bias???
         }
 
         // // Erase something???  What (decoded messages)?  Why?
@@ -412,7 +1008,7 @@ int Check_Calling_Stations(int num_decoded) {
         // }
     }
 
-    // Return index of final calling station in new_decoded[] or -1 if none????????????????????????
+    // Return index of final calling station in the decode arena or -1 if none????????????????????????
     if (message_test > 100)
         return message_test - 100;
     else {
@@ -0,0 +1,62 @@
+/**
+ * @brief Minimal Arduino.h stand-in for the native (host) test environment
+ *
+ * Provides just enough of the Teensy/Arduino core for the portable receiver and ft8_lib
+ * sources to build on the PlatformIO native platform.  Nothing here talks to hardware.
+ *
+ * @note Only [env:native] places test/test_native/include on the include path.  The
+ * teensy41 environment continues to use the real Arduino core.
+ */
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+
+// Teensy 4.1 memory placement qualifiers are meaningless on the host
+#define DMAMEM
+#define FASTRUN
+#define FLASHMEM
+#define PROGMEM
+
+// The legacy ft8_lib interface only uses String as a simple owned string
+typedef std::string String;
+
+/**
+ * @brief Milliseconds elapsed since the first call
+ */
+inline uint32_t millis(void) {
+    static const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+/**
+ * @brief Microseconds elapsed since the first call
+ */
+inline uint32_t micros(void) {
+    static const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// glibc lacks the BSD strlcpy()/strlcat() used throughout Pocket FT8
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = (len >= size) ? size - 1 : len;
+        memcpy(dst, src, n);
+        dst[n] = 0;
+    }
+    return len;
+}
+
+inline size_t strlcat(char* dst, const char* src, size_t size) {
+    size_t dlen = strnlen(dst, size);
+    if (dlen == size) return size + strlen(src);
+    return dlen + strlcpy(dst + dlen, src, size - dlen);
+}
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @brief Portable stand-in for the subset of CMSIS-DSP (arm_math.h) used by the receiver
+ *
+ * The Teensy build links the real CMSIS-DSP library.  The native environment instead builds
+ * src/Process_DSP.cpp against these host implementations so the spectral front end and the
+ * FT8 decoder can be exercised and timed on a laptop.
+ *
+ * @note arm_rfft_q15() follows the CMSIS fixed-point conventions (1.15 input, output scaled
+ * down by fftLen, full conjugate-symmetric spectrum) but computes in double precision.  Its
+ * results therefore agree with the MCU to within a count or so, not bit-for-bit.  Timings
+ * reported by the native benchmarks are for relative comparisons of the decode stages, not
+ * predictions of Cortex-M7 cycle counts.
+ */
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef int8_t q7_t;
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+typedef float float32_t;
+
+typedef enum {
+    ARM_MATH_SUCCESS = 0,
+    ARM_MATH_ARGUMENT_ERROR = -1,
+} arm_status;
+
+typedef struct {
+    uint16_t fftLen;
+} arm_cfft_radix4_instance_q15;
+
+typedef struct {
+    uint32_t fftLenReal;
+    uint8_t ifftFlagR;
+    uint8_t bitReverseFlagR;
+} arm_rfft_instance_q15;
+
+/**
+ * @brief Saturate a 32-bit intermediate into q15
+ */
+inline q15_t __SSAT16(int32_t x) {
+    return (q15_t)((x > 32767) ? 32767 : ((x < -32768) ? -32768 : x));
+}
+
+inline arm_status arm_rfft_init_q15(arm_rfft_instance_q15* S, uint32_t fftLenReal, uint32_t ifftFlagR, uint32_t bitReverseFlag) {
+    S->fftLenReal = fftLenReal;
+    S->ifftFlagR = (uint8_t)ifftFlagR;
+    S->bitReverseFlagR = (uint8_t)bitReverseFlag;
+    return ((fftLenReal & (fftLenReal - 1)) == 0) ? ARM_MATH_SUCCESS : ARM_MATH_ARGUMENT_ERROR;
+}
+
+/**
+ * @brief In-place radix-2 complex FFT of n points held as interleaved re/im doubles
+ */
+inline void host_cfft(double* x, unsigned n) {
+    // Bit reversal permutation
+    for (unsigned i = 1, j = 0; i < n; ++i) {
+        unsigned bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            double tr = x[2 * i], ti = x[2 * i + 1];
+            x[2 * i] = x[2 * j];
+            x[2 * i + 1] = x[2 * j + 1];
+            x[2 * j] = tr;
+            x[2 * j + 1] = ti;
+        }
+    }
+
+    // Butterflies
+    for (unsigned len = 2; len <= n; len <<= 1) {
+        double ang = -2 * M_PI / len;
+        double wr = cos(ang), wi = sin(ang);
+        for (unsigned i = 0; i < n; i += len) {
+            double cr = 1, ci = 0;
+            for (unsigned k = 0; k < len / 2; ++k) {
+                double* a = x + 2 * (i + k);
+                double* b = x + 2 * (i + k + len / 2);
+                double br = b[0] * cr - b[1] * ci;
+                double bi = b[0] * ci + b[1] * cr;
+                b[0] = a[0] - br;
+                b[1] = a[1] - bi;
+                a[0] += br;
+                a[1] += bi;
+                double t = cr * wr - ci * wi;
+                ci = cr * wi + ci * wr;
+                cr = t;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Forward real FFT producing fftLenReal complex (2*fftLenReal q15) outputs scaled by 1/fftLenReal
+ */
+inline void arm_rfft_q15(const arm_rfft_instance_q15* S, q15_t* pSrc, q15_t* pDst) {
+    unsigned n = S->fftLenReal;
+    static std::vector<double> work;
+    work.assign(2 * n, 0.0);
+    for (unsigned i = 0; i < n; ++i) work[2 * i] = pSrc[i];
+    host_cfft(work.data(), n);
+    for (unsigned i = 0; i < 2 * n; ++i) pDst[i] = __SSAT16((int32_t)floor(work[i] / n + 0.5));
+}
+
+inline void arm_shift_q15(const q15_t* pSrc, int8_t shiftBits, q15_t* pDst, uint32_t blockSize) {
+    for (uint32_t i = 0; i < blockSize; ++i) {
+        pDst[i] = (shiftBits >= 0) ? __SSAT16((int32_t)pSrc[i] << shiftBits) : (q15_t)(pSrc[i] >> -shiftBits);
+    }
+}
+
+inline void arm_mult_q15(const q15_t* pSrcA, const q15_t* pSrcB, q15_t* pDst, uint32_t blockSize) {
+    for (uint32_t i = 0; i < blockSize; ++i) pDst[i] = __SSAT16(((int32_t)pSrcA[i] * pSrcB[i]) >> 15);
+}
+
+inline void arm_cmplx_mag_squared_q15(const q15_t* pSrc, q15_t* pDst, uint32_t numSamples) {
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        int64_t re = pSrc[2 * i];
+        int64_t im = pSrc[2 * i + 1];
+        pDst[i] = (q15_t)((re * re + im * im) >> 17);  // 3.13 format as in CMSIS
+    }
+}
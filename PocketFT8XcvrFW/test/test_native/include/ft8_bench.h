@@ -0,0 +1,469 @@
+/**
+ * @brief Shared helpers for the native (host) FT8 receiver benchmarks and tests
+ *
+ * DISCUSSION:
+ *  The helpers replay 6400 Hz audio through the same spectral front end (extract_power() in
+ *  src/Process_DSP.cpp) and decoder stages (find_sync(), extract_likelihood(), bp_decode(),
+ *  unpack77_fields()) used by the firmware, timing each stage with the host's steady clock.
+ *
+ *  Audio comes from 16-bit mono 6400 Hz WAV recordings found in the directory named by the
+ *  FT8_BENCH_WAV_DIR environment variable (default test/test_native/wav).  Each recording
+ *  is treated as one or more 15 second timeslots beginning at the slot boundary, just as the
+ *  receiver acquires them.  When no recordings are available, a reproducible synthetic
+ *  timeslot of several FT8 signals in white noise stands in for the air.
+ *
+ * @note Include this header in exactly one source file of a test program.
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Process_DSP.h"
+#include "constants.h"
+#include "decode.h"
+#include "encode.h"
+#include "ft8LibIfce.h"
+#include "ldpc.h"
+#include "message.h"
+
+// Mirror the decoder parameters in src/decode_ft8.cpp
+static const int kBenchLDPC_iterations = 10;
+static const int kBenchMax_candidates = 30;
+static const int kBenchLDPC_group = (LDPC_BATCH && !LDPC_MIN_SUM && !LDPC_LAYERED) ? kLDPC_lanes : 1;  // Candidates per LDPC call
+static const int kBenchCandidate_pool = 60;
+static const int kBenchMin_score = 40;
+
+static const int kBenchSampleRate = 6400;                                  // Samples/second
+static const int kBenchSlotSamples = 15 * kBenchSampleRate;                // One FT8 timeslot
+static const int kBenchSpectrogramSize = ft8_msg_samples * ft8_buffer * 4;  // One byte entries
+
+// The spectral front end's state (see src/Process_DSP.cpp; its buffers are declared in Process_DSP.h)
+extern int offset_step;
+
+/**
+ * @brief Nanosecond stopwatch
+ */
+class BenchTimer {
+   public:
+    BenchTimer() : t0(std::chrono::steady_clock::now()) {}
+    double ns(void) const { return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count(); }
+
+   private:
+    std::chrono::steady_clock::time_point t0;
+};
+
+/**
+ * @brief Accumulated per-stage timings and counts
+ */
+struct BenchStats {
+    int slots;             // Timeslots replayed
+    int candidates;        // Candidates find_sync() and suppress_candidates() passed to the decoder
+    int ldpc_runs;         // Invocations of the LDPC decoder
+    int ldpc_runs_saved;   // Near-duplicate candidates suppress_candidates() merged away
+    int ldpc_iterations;   // Iterations over all LDPC runs
+    int converged;         // LDPC runs that satisfied every parity check
+    int converged_iterations[kBenchLDPC_iterations + 1];  // Histogram of the iterations those runs took
+    int decodes;           // Unique messages decoded
+    int duplicates;        // Repeated decodes payload_set_insert() rejected before unpacking
+    double spectrum_ns;    // extract_power() for all symbols
+    double sync_ns;        // find_sync() and suppress_candidates()
+    double likelihood_ns;  // extract_likelihood()
+    double ldpc_ns;        // bp_decode() or ms_decode() (LDPC_MIN_SUM)
+    double unpack_ns;      // CRC check, duplicate detection and unpack77_fields()
+
+    BenchStats() { memset(this, 0, sizeof(*this)); }
+};
+
+/**
+ * @brief Read a 16-bit PCM mono 6400 Hz WAV file
+ * @param path Filename
+ * @param samples Receives the audio samples
+ * @return true==success
+ */
+inline bool bench_read_wav(const char* path, std::vector<int16_t>& samples) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) return false;
+
+    char riff[12];
+    bool ok = (fread(riff, 1, 12, f) == 12) && (memcmp(riff, "RIFF", 4) == 0) && (memcmp(riff + 8, "WAVE", 4) == 0);
+    uint16_t channels = 0, bits = 0;
+    uint32_t rate = 0;
+
+    // Walk the chunks until we find the audio data
+    while (ok) {
+        char id[4];
+        uint32_t size;
+        if (fread(id, 1, 4, f) != 4 || fread(&size, 4, 1, f) != 1) {
+            ok = false;
+            break;
+        }
+        if (memcmp(id, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            ok = (size >= 16) && (fread(fmt, 1, 16, f) == 16);
+            memcpy(&channels, fmt + 2, 2);
+            memcpy(&rate, fmt + 4, 4);
+            memcpy(&bits, fmt + 14, 2);
+            fseek(f, size - 16 + (size & 1), SEEK_CUR);
+        } else if (memcmp(id, "data", 4) == 0) {
+            ok = (channels == 1) && (bits == 16) && (rate == (uint32_t)kBenchSampleRate);
+            if (ok) {
+                samples.resize(size / 2);
+                ok = fread(samples.data(), 2, samples.size(), f) == samples.size();
+            }
+            break;
+        } else {
+            fseek(f, size + (size & 1), SEEK_CUR);
+        }
+    }
+    fclose(f);
+    if (!ok) fprintf(stderr, "Skipping %s (need 16-bit mono %d Hz WAV)\n", path, kBenchSampleRate);
+    return ok;
+}
+
+/**
+ * @brief Gaussian noise from a fixed-seed generator so synthetic runs are reproducible
+ */
+class BenchNoise {
+   public:
+    explicit BenchNoise(uint32_t seed) : state(seed) {}
+    double uniform(void) {
+        state = state * 1664525u + 1013904223u;
+        return ((state >> 8) + 0.5) / 16777216.0;
+    }
+    double gaussian(void) { return sqrt(-2 * log(uniform())) * cos(2 * M_PI * uniform()); }
+
+   private:
+    uint32_t state;
+};
+
+/**
+ * @brief Put the CRC-14 of a packed message's first 77 bits into its bits 77-90, as a transmitter does
+ * @param message K_BYTES of packed message bits
+ */
+inline void bench_add_crc(uint8_t message[]) {
+    message[9] &= 0xF8;
+    message[10] = 0;
+    message[11] = 0;
+    uint16_t checksum = crc(message, 96 - 14);
+    message[9] |= (uint8_t)(checksum >> 11);
+    message[10] = (uint8_t)(checksum >> 3);
+    message[11] = (uint8_t)(checksum << 5);
+}
+
+/**
+ * @brief A given message's LDPC codeword, sent as BPSK over an AWGN channel
+ * @param noise Noise source
+ * @param ebn0_db Channel Eb/N0
+ * @param message The K message bits, packed (e.g. by pack77() and bench_add_crc())
+ * @param bits Receives the codeword's N bits, one per byte
+ * @param log174 Receives the bits' log(P(1) / P(0)), normalized as extract_likelihood() does
+ */
+inline void bench_modulate_frame(BenchNoise& noise, double ebn0_db, const uint8_t message[], uint8_t bits[], float log174[]) {
+    uint8_t codeword[(N + 7) / 8];
+    encode174(message, codeword);
+
+    // BPSK with Es/N0 = R * Eb/N0, log(P(1) / P(0)) likelihoods as the decoders expect
+    double rate = (double)K / N;
+    double sigma = sqrt(1.0 / (2 * rate * pow(10.0, ebn0_db / 10)));
+    for (int i = 0; i < N; ++i) {
+        bits[i] = (codeword[i / 8] >> (7 - i % 8)) & 1;
+        double y = (bits[i] ? 1.0 : -1.0) + sigma * noise.gaussian();
+        log174[i] = (float)(2 * y / (sigma * sigma));
+    }
+
+    // Normalize as extract_likelihood() does
+    float sum = 0, sum2 = 0;
+    for (int i = 0; i < N; ++i) {
+        sum += log174[i];
+        sum2 += log174[i] * log174[i];
+    }
+    float variance = (sum2 - sum * sum / N) / N;
+    float norm_factor = sqrtf(16.0f / variance);
+    for (int i = 0; i < N; ++i) log174[i] *= norm_factor;
+}
+
+/**
+ * @brief A random LDPC codeword, sent as BPSK over an AWGN channel, for the LDPC decoder tests
+ * @param noise Random source
+ * @param ebn0_db Channel Eb/N0
+ * @param bits Receives the codeword's N bits, one per byte
+ * @param log174 Receives the bits' log(P(1) / P(0)), normalized as extract_likelihood() does
+ * @param with_crc Make the last 14 message bits the CRC of the first 77, as a transmitter does
+ */
+inline void bench_make_frame(BenchNoise& noise, double ebn0_db, uint8_t bits[], float log174[], bool with_crc = false) {
+    uint8_t message[K_BYTES];
+    for (int i = 0; i < K_BYTES; ++i) message[i] = (uint8_t)(noise.uniform() * 256);
+    message[K_BYTES - 1] &= (uint8_t)(0xFF00 >> (K % 8));
+    if (with_crc) bench_add_crc(message);
+    bench_modulate_frame(noise, ebn0_db, message, bits, log174);
+}
+
+/**
+ * @brief Add one FT8 transmission to a timeslot of audio
+ * @param text Message text (e.g. "CQ K1ABC FN42")
+ * @param freq_hz Audio frequency of tone 0
+ * @param start_s Transmission start relative to the slot boundary (nominally 0.5 s)
+ * @param amplitude Peak amplitude in q15 counts
+ * @param audio Timeslot audio accumulated in doubles
+ * @return true==success
+ */
+inline bool bench_add_signal(const char* text, double freq_hz, double start_s, double amplitude, std::vector<double>& audio) {
+    uint8_t payload[FTX_PAYLOAD_LENGTH_BYTES];
+    uint8_t itone[79];
+    if (pack77(text, payload) != 0) return false;
+    genft8(payload, itone);
+
+    const int samples_per_symbol = kBenchSampleRate * 160 / 1000;  // 1024
+    int n0 = (int)(start_s * kBenchSampleRate);
+    double phase = 0;
+    for (int k = 0; k < 79; ++k) {
+        double dphi = 2 * M_PI * (freq_hz + itone[k] * 6.25) / kBenchSampleRate;
+        for (int i = 0; i < samples_per_symbol; ++i) {
+            int n = n0 + k * samples_per_symbol + i;
+            if (n >= 0 && n < (int)audio.size()) audio[n] += amplitude * sin(phase);
+            phase += dphi;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Build a reproducible synthetic timeslot of FT8 traffic in white noise
+ * @param seed Noise generator seed (vary it to build several distinct slots)
+ * @param samples Receives kBenchSlotSamples of audio
+ *
+ * SNRs are quoted in WSJT-X's 2500 Hz reference bandwidth and span the comfortable to
+ * the marginal so the decoder's yield is sensitive to changes in each stage.
+ */
+inline void bench_synthesize_slot(uint32_t seed, std::vector<int16_t>& samples) {
+    static const struct {
+        const char* text;
+        double freq_hz;
+        double snr_db;
+    } traffic[] = {
+        {"CQ K1ABC FN42", 512.5, -4},    {"KQ7B W1AW FN31", 734.0, -8},    {"W9XYZ K1ABC -11", 905.0, -10},
+        {"CQ DX JA1XYZ PM95", 1187.5, -12}, {"AA0AAA AA9AAA EN50", 1390.0, -14}, {"K9AN K1JT R-12", 1603.0, -16},
+        {"CQ EA8BFK IL38", 1856.0, -18},  {"N0CALL G4ABC RR73", 2045.0, -19}, {"CQ POTA KQ7B DN16", 2210.0, -20},
+    };
+    const double sigma = 4000;  // Noise standard deviation in q15 counts
+    BenchNoise noise(seed);
+
+    std::vector<double> audio(kBenchSlotSamples, 0.0);
+    for (unsigned i = 0; i < sizeof(traffic) / sizeof(traffic[0]); ++i) {
+        double snr = pow(10.0, traffic[i].snr_db / 10);  // Signal power / noise power in 2500 Hz
+        double amplitude = sqrt(2 * snr * sigma * sigma * 2500.0 / (kBenchSampleRate / 2));
+        double start_s = 0.5 + 0.08 * noise.uniform();   // A little DT scatter
+        double freq_hz = traffic[i].freq_hz + ((seed * 7 + i * 3) % 8) * 0.7;
+        bench_add_signal(traffic[i].text, freq_hz, start_s, amplitude, audio);
+    }
+
+    samples.resize(kBenchSlotSamples);
+    for (int n = 0; n < kBenchSlotSamples; ++n) {
+        double x = audio[n] + sigma * noise.gaussian();
+        samples[n] = (int16_t)((x > 32767) ? 32767 : ((x < -32768) ? -32768 : x));
+    }
+}
+
+/**
+ * @brief Gather the benchmark's timeslots from WAV recordings or, lacking any, synthesize them
+ * @param slots Receives one vector of audio per timeslot
+ * @param synthetic_slots Number of synthetic slots to build when no recordings exist
+ */
+inline void bench_load_slots(std::vector<std::vector<int16_t> >& slots, int synthetic_slots = 4) {
+    const char* dir = getenv("FT8_BENCH_WAV_DIR");
+    if (dir == NULL) dir = "test/test_native/wav";
+
+    DIR* d = opendir(dir);
+    if (d != NULL) {
+        std::vector<std::string> names;
+        for (struct dirent* e = readdir(d); e != NULL; e = readdir(d)) {
+            size_t len = strlen(e->d_name);
+            if (len > 4 && strcasecmp(e->d_name + len - 4, ".wav") == 0) names.push_back(std::string(dir) + "/" + e->d_name);
+        }
+        closedir(d);
+
+        for (size_t i = 0; i < names.size(); ++i) {
+            std::vector<int16_t> wav;
+            if (!bench_read_wav(names[i].c_str(), wav)) continue;
+            for (size_t n = 0; n + ft8_msg_samples * input_gulp_size <= wav.size(); n += kBenchSlotSamples) {
+                size_t end = (n + kBenchSlotSamples < wav.size()) ? n + kBenchSlotSamples : wav.size();
+                slots.push_back(std::vector<int16_t>(wav.begin() + n, wav.begin() + end));
+            }
+        }
+    }
+
+    if (slots.empty()) {
+        printf("No recordings in %s, synthesizing %d timeslots\n", dir, synthetic_slots);
+        for (int s = 0; s < synthetic_slots; ++s) {
+            slots.push_back(std::vector<int16_t>());
+            bench_synthesize_slot(1 + s, slots.back());
+        }
+    }
+}
+
+/**
+ * @brief Replay one timeslot of audio through extract_power() as process_data() feeds it
+ * @param samples The timeslot's audio
+ * @param stats Accumulates spectrum_ns
+ *
+ * The resulting spectrogram is handed off to the decoder as process_FT8_FFT() does, so it is
+ * available from decode_spectrogram() until release_spectrogram().
+ */
+inline void bench_build_spectrogram(const std::vector<int16_t>& samples, BenchStats& stats) {
+    memset(audio_ring, 0, sizeof(audio_ring));  // Each timeslot starts from silence
+    for (int gulp = 0; gulp < ft8_msg_samples; ++gulp) {
+        // Emulate process_data() appending a new gulp of audio blocks to audio_ring[]
+        for (int b = 0; b < num_que_blocks; ++b) {
+            q15_t block[block_size];
+            for (int i = 0; i < block_size; ++i) {
+                size_t n = (size_t)gulp * input_gulp_size + b * block_size + i;
+                block[i] = (n < samples.size()) ? samples[n] : 0;
+            }
+            ingest_audio_block(block);
+        }
+
+        BenchTimer t;
+        extract_power(offset_step * gulp);
+        stats.spectrum_ns += t.ns();
+    }
+    handoff_spectrogram();
+}
+
+/**
+ * @brief Decode one timeslot's spectrogram as ft8_decode() does, timing each stage
+ * @param power The spectrogram (one byte entries or PackedRows)
+ * @param stats Accumulates the decoder stage timings and counts
+ * @param verbose Print the decoded messages
+ * @param search find_sync()'s search strategy
+ * @param suppress Merge near-duplicate candidates with suppress_candidates() (or take find_sync()'s best)
+ * @param num_blocks Symbols of the timeslot to search, fewer than ft8_msg_samples for an early pass (which, as
+ *  ft8_decode_early() does, erases up to kMax_erased_symbols not yet received)
+ * @param payloads Receives the decoded messages' payloads, if not NULL
+ * @return Number of unique messages decoded
+ */
+template <typename Entry>
+inline int bench_decode_spectrogram(const Entry* power, BenchStats& stats, bool verbose = false, SyncSearch search = kSync_exhaustive,
+                                    bool suppress = true, int num_blocks = ft8_msg_samples, PayloadSet* payloads = NULL) {
+    Candidate candidate_list[kBenchCandidate_pool];
+    PayloadSet decoded;
+    payload_set_clear(decoded);
+    int num_decoded = 0;
+    const int erased_symbols = (num_blocks < ft8_msg_samples) ? kMax_erased_symbols : 0;
+
+    BenchTimer ts;
+    int num_candidates;
+    if (suppress) {
+        int runs_saved;
+        num_candidates = find_sync(power, num_blocks, ft8_buffer, kCostas_map, kBenchCandidate_pool, candidate_list, kBenchMin_score, search, erased_symbols);
+        num_candidates = suppress_candidates(candidate_list, num_candidates, kBenchMax_candidates, &runs_saved);
+        stats.ldpc_runs_saved += runs_saved;
+    } else {
+        num_candidates = find_sync(power, num_blocks, ft8_buffer, kCostas_map, kBenchMax_candidates, candidate_list, kBenchMin_score, search, erased_symbols);
+    }
+    stats.sync_ns += ts.ns();
+    stats.candidates += num_candidates;
+
+    for (int idx = 0; idx < num_candidates; idx += kBenchLDPC_group) {
+        LDPCBatch batch;
+        batch.num_lanes = std::min(kBenchLDPC_group, num_candidates - idx);
+        float log174[kBenchLDPC_group][174];
+        BenchTimer tl;
+        for (int g = 0; g < batch.num_lanes; ++g) {
+            extract_likelihood(power, ft8_buffer, candidate_list[idx + g], kGray_map, log174[g], num_blocks);
+            batch.codeword[g] = log174[g];
+        }
+        stats.likelihood_ns += tl.ns();
+
+        BenchTimer tb;
+#if LDPC_BATCH && !LDPC_MIN_SUM && !LDPC_LAYERED
+        bp_decode_batch(batch, kBenchLDPC_iterations);
+#else
+        for (int g = 0; g < batch.num_lanes; ++g) {
+#if LDPC_MIN_SUM
+            int8_t llr[N];
+            quantize_likelihood(log174[g], llr);
+            ms_decode(llr, kBenchLDPC_iterations, batch.plain[g], &batch.ok[g], &batch.iterations[g]);
+#elif LDPC_LAYERED
+            bp_decode_layered(log174[g], kBenchLDPC_iterations, batch.plain[g], &batch.ok[g], &batch.iterations[g]);
+#else
+            bp_decode(log174[g], kBenchLDPC_iterations, batch.plain[g], &batch.ok[g], &batch.iterations[g]);
+#endif
+        }
+#endif
+        stats.ldpc_ns += tb.ns();
+
+        for (int g = 0; g < batch.num_lanes; ++g) {
+            Candidate cand = candidate_list[idx + g];
+            const uint8_t* plain = batch.plain[g];
+            int n_errors = batch.ok[g];
+            int iterations = batch.iterations[g];
+            stats.ldpc_runs++;
+            stats.ldpc_iterations += iterations;
+            if (n_errors > 0) continue;
+            stats.converged++;
+            stats.converged_iterations[iterations]++;
+
+            BenchTimer tu;
+            uint8_t a91[K_BYTES];
+            pack_bits(plain, K, a91);
+            uint16_t chksum = ((a91[9] & 0x07) << 11) | (a91[10] << 3) | (a91[11] >> 5);
+            a91[9] &= 0xF8;
+            a91[10] = 0;
+            a91[11] = 0;
+            if (chksum != crc(a91, 96 - 14)) {
+                stats.unpack_ns += tu.ns();
+                continue;
+            }
+            if (!payload_set_insert(decoded, a91)) {
+                stats.duplicates++;
+                stats.unpack_ns += tu.ns();
+                continue;
+            }
+
+            char field1[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE];
+            char field2[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE];
+            char field3[FTX_REPORTS_BFRSIZE];
+            MsgType msgType;
+            if (unpack77_fields(a91, field1, field2, field3, &msgType) >= 0) {
+                num_decoded++;
+                if (verbose) printf("  %4d %5.0f Hz  %s %s %s\n", cand.score, (cand.freq_offset + cand.freq_sub / 2.0f) * 6.25f, field1, field2, field3);
+            }
+            stats.unpack_ns += tu.ns();
+        }
+    }
+
+    stats.decodes += num_decoded;
+    if (payloads != NULL) *payloads = decoded;
+    return num_decoded;
+}
+
+/**
+ * @brief Print a BenchStats report
+ */
+inline void bench_report(const char* title, const BenchStats& s) {
+    double slots = s.slots ? s.slots : 1;
+    double cands = s.candidates ? s.candidates : 1;
+    printf("\n%s: %d timeslots, %d candidates, %d LDPC runs, %d decodes\n", title, s.slots, s.candidates, s.ldpc_runs, s.decodes);
+    printf("  extract_power      %12.0f ns/timeslot %10.0f ns/symbol\n", s.spectrum_ns / slots, s.spectrum_ns / slots / ft8_msg_samples);
+    printf("  find_sync          %12.0f ns/timeslot\n", s.sync_ns / slots);
+    printf("  extract_likelihood %12.0f ns/timeslot %10.0f ns/candidate\n", s.likelihood_ns / slots, s.likelihood_ns / cands);
+    printf("  %-18s %12.0f ns/timeslot %10.0f ns/candidate\n", LDPC_MIN_SUM ? "ms_decode" : (LDPC_LAYERED ? "bp_decode_layered" : (LDPC_BATCH ? "bp_decode_batch" : "bp_decode")),
+           s.ldpc_ns / slots, s.ldpc_ns / cands);
+    printf("  LDPC iterations    %12.2f /run, %d of %d runs converged, taking:", s.ldpc_iterations / (double)(s.ldpc_runs ? s.ldpc_runs : 1), s.converged,
+           s.ldpc_runs);
+    for (int i = 0; i <= kBenchLDPC_iterations; ++i) printf(" %d", s.converged_iterations[i]);
+    printf(" (0..%d iterations)\n", kBenchLDPC_iterations);
+    printf("  crc+unpack77       %12.0f ns/timeslot\n", s.unpack_ns / slots);
+    printf("  LDPC runs saved    %12.1f /timeslot\n", s.ldpc_runs_saved / slots);
+    printf("  duplicates dropped %12.1f /timeslot\n", s.duplicates / slots);
+    printf("  decoder total      %12.0f ns/timeslot\n", (s.sync_ns + s.likelihood_ns + s.ldpc_ns + s.unpack_ns) / slots);
+}
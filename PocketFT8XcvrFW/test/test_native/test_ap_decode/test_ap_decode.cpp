@@ -0,0 +1,207 @@
+/**
+ * @brief Host tests of a priori (AP) decoding with a QSO partner's known callsigns
+ *
+ * DISCUSSION:
+ *  While the Sequencer awaits its QSO partner's reply, ft8_decode() knows both callsigns of
+ *  the message it expects.  Weak BPSK/AWGN frames of such replies ("K1ABC W9XYZ R-12" and
+ *  the like) are decoded by bp_decode() alone and again after apply_apriori_callsigns()
+ *  clamps the callsign and i3 bits.  The test reports both frame error rates and counts any
+ *  wrong messages.  Replies from another station, decoded with the partner's callsigns
+ *  forced, must be caught by callsigns_match().  Noise-only likelihoods measure how often
+ *  AP decoding manufactures a reply that passes the CRC and the callsign check.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_ap_decode -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+static const int kFrames = 400;
+static const char* kMy_call = "K1ABC";
+static const char* kTheir_call = "W9XYZ";
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Decode log174 with bp_decode(), returning true for a codeword whose CRC is valid
+static bool decode_frame(float log174[], uint8_t plain[]) {
+    int n_errors = 0;
+    bp_decode(log174, kBenchLDPC_iterations, plain, &n_errors);
+    if (n_errors > 0) return false;
+
+    uint8_t a91[K_BYTES];
+    pack_bits(plain, K, a91);
+    uint16_t chksum = ((a91[9] & 0x07) << 11) | (a91[10] << 3) | (a91[11] >> 5);
+    a91[9] &= 0xF8;
+    a91[10] = 0;
+    a91[11] = 0;
+    return chksum == crc(a91, 96 - 14);
+}
+
+/**
+ * @brief pack_callsigns() packs the callsigns exactly as pack77() does in a full message
+ */
+void test_ap_callsign_bits(void) {
+    uint8_t known[K_BYTES];
+    uint8_t full[K_BYTES];
+    TEST_ASSERT_EQUAL_INT(0, pack_callsigns(kMy_call, kTheir_call, known));
+    TEST_ASSERT_EQUAL_INT(0, pack77("K1ABC W9XYZ R-12", full));
+
+    float log174[174];
+    for (int i = 0; i < N; ++i) log174[i] = (i & 1) ? 3.0f : -3.0f;
+    apply_apriori_callsigns(log174, known);
+    for (int i = 0; i < 77; ++i) {
+        bool one = (full[i >> 3] >> (7 - (i & 7))) & 1;
+        if (i < kAP_callsign_bits || i >= 74) {
+            TEST_ASSERT_TRUE(fabsf(log174[i]) > 3.0f);
+            TEST_ASSERT_EQUAL_INT(one, log174[i] > 0);
+        } else {
+            TEST_ASSERT_EQUAL_FLOAT((i & 1) ? 3.0f : -3.0f, log174[i]);
+        }
+    }
+}
+
+/**
+ * @brief AP decoding recovers replies that bp_decode() alone misses and never returns a wrong one
+ */
+void test_ap_replies(void) {
+    static const char* kExtras[] = {"-12", "R-07", "RR73", "RRR", "73", "+03", "R+01", "-21"};
+    uint8_t known[K_BYTES];
+    pack_callsigns(kMy_call, kTheir_call, known);
+
+    BenchNoise noise(0xA9);
+    const double kEbN0[] = {0.0, 1.0, 2.0};
+    int ap_gain = 0;
+    for (unsigned e = 0; e < sizeof(kEbN0) / sizeof(kEbN0[0]); ++e) {
+        int bp_decodes = 0, ap_decodes = 0, wrong = 0;
+        for (int f = 0; f < kFrames; ++f) {
+            char text[32];
+            snprintf(text, sizeof(text), "%s %s %s", kMy_call, kTheir_call, kExtras[f % 8]);
+            uint8_t message[K_BYTES];
+            memset(message, 0, sizeof(message));
+            TEST_ASSERT_EQUAL_INT(0, pack77(text, message));
+            bench_add_crc(message);
+
+            uint8_t bits[174], plain[174];
+            float log174[174];
+            bench_modulate_frame(noise, kEbN0[e], message, bits, log174);
+
+            float ap174[174];
+            memcpy(ap174, log174, sizeof(ap174));
+            if (decode_frame(log174, plain)) {
+                bp_decodes++;
+                wrong += memcmp(bits, plain, N) != 0;
+            }
+            apply_apriori_callsigns(ap174, known);
+            if (decode_frame(ap174, plain)) {
+                ap_decodes++;
+                wrong += memcmp(bits, plain, N) != 0;
+            }
+        }
+        printf("Eb/N0 %.1f dB:  bp_decode %d/%d, with AP %d/%d, wrong %d\n", kEbN0[e], bp_decodes, kFrames, ap_decodes, kFrames, wrong);
+        TEST_ASSERT_EQUAL_INT(0, wrong);
+        TEST_ASSERT_TRUE(ap_decodes >= bp_decodes);
+        ap_gain += ap_decodes - bp_decodes;
+    }
+    TEST_ASSERT_GREATER_THAN_INT(kFrames / 4, ap_gain);
+}
+
+/**
+ * @brief callsigns_match() accepts only the expected callsigns, in order
+ */
+void test_ap_callsign_check(void) {
+    static const struct {
+        const char* text;
+        bool match;
+    } messages[] = {
+        {"K1ABC W9XYZ R-12", true}, {"K1ABC W9XYZ RR73", true}, {"W9XYZ K1ABC R-12", false},
+        {"K1ABC W9XYA R-12", false}, {"K1ABD W9XYZ -07", false}, {"CQ W9XYZ EN50", false},
+    };
+    for (unsigned m = 0; m < sizeof(messages) / sizeof(messages[0]); ++m) {
+        uint8_t a77[K_BYTES];
+        TEST_ASSERT_EQUAL_INT(0, pack77(messages[m].text, a77));
+        TEST_ASSERT_EQUAL_INT(messages[m].match, callsigns_match(a77, kMy_call, kTheir_call));
+    }
+}
+
+/**
+ * @brief A reply from another station, AP decoded with the partner's callsigns, is rejected
+ *
+ * W9XYY's packed callsign differs from W9XYZ's in a few bits, so the LDPC decoder can overrule
+ * those forced bits of a strong "K1ABC W9XYY ..." frame and return a CRC-valid codeword that
+ * isn't our partner's reply.  Every such decode must fail callsigns_match().
+ */
+void test_ap_mismatched_decode(void) {
+    static const char* kExtras[] = {"-12", "R-07", "RR73", "73"};
+    uint8_t known[K_BYTES];
+    pack_callsigns(kMy_call, kTheir_call, known);
+
+    BenchNoise noise(0xA11);
+    int mismatched = 0;
+    for (int f = 0; f < kFrames; ++f) {
+        char text[32];
+        snprintf(text, sizeof(text), "%s W9XYY %s", kMy_call, kExtras[f % 4]);
+        uint8_t message[K_BYTES];
+        memset(message, 0, sizeof(message));
+        TEST_ASSERT_EQUAL_INT(0, pack77(text, message));
+        bench_add_crc(message);
+
+        uint8_t bits[174], plain[174];
+        float log174[174];
+        bench_modulate_frame(noise, 6.0, message, bits, log174);
+        apply_apriori_callsigns(log174, known);
+        if (!decode_frame(log174, plain)) continue;
+
+        uint8_t a77[K_BYTES];
+        pack_bits(plain, K, a77);
+        TEST_ASSERT_FALSE(callsigns_match(a77, kMy_call, kTheir_call));
+        mismatched++;
+    }
+    printf("Replies from W9XYY:  %d of %d AP decoded, all rejected by callsigns_match()\n", mismatched, kFrames);
+    TEST_ASSERT_GREATER_THAN_INT(0, mismatched);
+}
+
+/**
+ * @brief AP decoding of noise rarely produces a reply with a valid CRC, and none that passes the callsign check
+ */
+void test_ap_noise(void) {
+    const int kNoise_frames = 2000;
+    uint8_t known[K_BYTES];
+    pack_callsigns(kMy_call, kTheir_call, known);
+
+    BenchNoise noise(0xA10);
+    int false_decodes = 0, false_replies = 0;
+    for (int f = 0; f < kNoise_frames; ++f) {
+        float log174[174];
+        for (int i = 0; i < N; ++i) log174[i] = (float)(4 * noise.gaussian());
+        apply_apriori_callsigns(log174, known);
+        uint8_t plain[174];
+        if (decode_frame(log174, plain)) {
+            uint8_t a77[K_BYTES];
+            pack_bits(plain, K, a77);
+            char field1[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE], field2[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE], field3[FTX_REPORTS_BFRSIZE];
+            MsgType msgType;
+            unpack77_fields(a77, field1, field2, field3, &msgType);
+            printf("False decode:  '%s %s %s'\n", field1, field2, field3);
+            false_decodes++;
+            false_replies += callsigns_match(a77, kMy_call, kTheir_call);
+        }
+    }
+    printf("AP on noise:  %d false decodes in %d, %d with the expected callsigns\n", false_decodes, kNoise_frames, false_replies);
+    TEST_ASSERT_TRUE(false_decodes * 200 <= kNoise_frames);
+    TEST_ASSERT_EQUAL_INT(0, false_replies);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ap_callsign_bits);
+    RUN_TEST(test_ap_replies);
+    RUN_TEST(test_ap_callsign_check);
+    RUN_TEST(test_ap_mismatched_decode);
+    RUN_TEST(test_ap_noise);
+    return UNITY_END();
+}
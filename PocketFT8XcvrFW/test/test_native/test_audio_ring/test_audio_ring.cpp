@@ -0,0 +1,96 @@
+/**
+ * @brief Host test of the zero-copy audio ring feeding extract_power()
+ *
+ * DISCUSSION:
+ *  process_data() formerly copied each gulp of queue blocks into input_gulp[] and shifted it
+ *  into a 3 gulp dsp_buffer[], from which extract_power() windowed the FFT input.  The audio
+ *  now lands in audio_ring[] and window_audio() reads it with wrap-aware indexing.  These tests
+ *  replay the same audio through an emulation of the former path and require the windowed
+ *  FFT input to be bit-identical, symbol after symbol, as the ring wraps.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_audio_ring -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+extern float window[FFT_SIZE];     // extract_power()'s windows (see src/Process_DSP.cpp)
+extern q15_t window_q15[FFT_SIZE];
+
+static q15_t legacy_dsp_buffer[3 * input_gulp_size];  // The former dsp_buffer[]
+
+void setUp(void) {
+    memset(audio_ring, 0, sizeof(audio_ring));
+    memset(legacy_dsp_buffer, 0, sizeof(legacy_dsp_buffer));
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief Feed one gulp to both paths as process_data() does
+ */
+static void ingest_gulp(const q15_t* input_gulp) {
+    for (int i = 0; i < num_que_blocks; i++) ingest_audio_block(input_gulp + block_size * i);
+
+    for (int i = 0; i < input_gulp_size; i++) {
+        legacy_dsp_buffer[i] = legacy_dsp_buffer[i + input_gulp_size];
+        legacy_dsp_buffer[i + input_gulp_size] = legacy_dsp_buffer[i + 2 * input_gulp_size];
+        legacy_dsp_buffer[i + 2 * input_gulp_size] = input_gulp[i];
+    }
+}
+
+/**
+ * @brief Compare both windowing paths with the same windowing of dsp_buffer[] for both time offsets
+ */
+static void check_fft_input(void) {
+    q15_t expected[FFT_SIZE];
+    for (int time_sub = 0; time_sub <= input_gulp_size / 2; time_sub += input_gulp_size / 2) {
+        for (int i = 0; i < FFT_SIZE; i++) expected[i] = (q15_t)((float)legacy_dsp_buffer[i + time_sub] * window[i]);
+        window_audio_float(time_sub);
+        TEST_ASSERT_EQUAL_INT16_ARRAY_MESSAGE(expected, window_dsp_buffer, FFT_SIZE, "Float FFT input differs");
+
+        arm_mult_q15(&legacy_dsp_buffer[time_sub], window_q15, expected, FFT_SIZE);
+        window_audio_q15(time_sub);
+        TEST_ASSERT_EQUAL_INT16_ARRAY_MESSAGE(expected, window_dsp_buffer, FFT_SIZE, "Q15 FFT input differs");
+    }
+}
+
+/**
+ * @brief Full-scale noise over several trips around the ring, from an arbitrary starting head
+ */
+void test_ring_matches_dsp_buffer(void) {
+    BenchNoise noise(7);
+    q15_t input_gulp[input_gulp_size];
+    audio_ring_head = 0u - 5 * block_size;  // Also exercise the head's wrap modulo 2^32
+    for (int gulp = 0; gulp < 4 * audio_ring_size / input_gulp_size + 3; ++gulp) {
+        for (int i = 0; i < input_gulp_size; i++) input_gulp[i] = (q15_t)(noise.uniform() * 65535 - 32768);
+        ingest_gulp(input_gulp);
+        check_fft_input();
+    }
+}
+
+/**
+ * @brief Every symbol of a synthetic timeslot of FT8 traffic, starting from silence
+ */
+void test_ring_timeslot(void) {
+    std::vector<int16_t> samples;
+    bench_synthesize_slot(3, samples);
+    q15_t input_gulp[input_gulp_size];
+    audio_ring_head = 0;
+    for (int gulp = 0; gulp < ft8_msg_samples; ++gulp) {
+        for (int i = 0; i < input_gulp_size; i++) input_gulp[i] = samples[(size_t)gulp * input_gulp_size + i];
+        ingest_gulp(input_gulp);
+        check_fft_input();
+    }
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_ring_matches_dsp_buffer);
+    RUN_TEST(test_ring_timeslot);
+    return UNITY_END();
+}
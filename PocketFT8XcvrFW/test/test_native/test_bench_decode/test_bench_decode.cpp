@@ -0,0 +1,58 @@
+/**
+ * @brief Host benchmark of the FT8 receive pipeline
+ *
+ * DISCUSSION:
+ *  Replays 6400 Hz timeslots (see ft8_bench.h) through extract_power(), find_sync(),
+ *  extract_likelihood(), bp_decode() and unpack77_fields() and reports each stage's
+ *  cost per timeslot and per candidate along with the number of decoded messages.  The
+ *  absolute timings are the host's, not the Teensy's, but they provide a reproducible
+ *  baseline for judging changes to the decode path before trying them on the radio.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_bench_decode -v
+ *  FT8_BENCH_WAV_DIR=/path/to/recordings pio test -e native -f test_native/test_bench_decode -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+static std::vector<std::vector<int16_t> > slots;  // Timeslots of audio under test
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief Time every stage of the receive pipeline over all timeslots
+ */
+void test_bench_pipeline(void) {
+    BenchStats stats;
+    for (size_t s = 0; s < slots.size(); ++s) {
+        printf("Timeslot %u:\n", (unsigned)s);
+        bench_build_spectrogram(slots[s], stats);
+        const uint8_t* power = decode_spectrogram();
+#if SPECTROGRAM_4BIT
+        bench_decode_spectrogram((const PackedRow*)power, stats, true);
+#else
+        bench_decode_spectrogram(power, stats, true);
+#endif
+        release_spectrogram(power);
+        stats.slots++;
+    }
+    bench_report("Baseline pipeline", stats);
+
+    // The synthetic traffic includes several comfortably strong signals
+    TEST_ASSERT_GREATER_THAN_INT(0, stats.decodes);
+    TEST_ASSERT_EQUAL_UINT(0, spectrogram_overruns);
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+    bench_load_slots(slots);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_pipeline);
+    return UNITY_END();
+}
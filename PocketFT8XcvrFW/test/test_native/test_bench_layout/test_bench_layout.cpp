@@ -0,0 +1,184 @@
+/**
+ * @brief Host benchmark of the spectrogram layouts (SPECTROGRAM_PLANAR)
+ *
+ * DISCUSSION:
+ *  Each timeslot's spectrogram is copied into both layouts, the original interleaved rows
+ *  ((block * 4 + alt) * ft8_buffer + bin) and planar rows padded to 32 byte cache lines
+ *  ((alt * ft8_msg_samples + block) * 416 + bin), and find_sync() and extract_likelihood()
+ *  are timed on each.  Both must find the same candidates.
+ *
+ *  The host's caches are far larger than the Teensy's, so the benchmark also replays both
+ *  functions' spectrogram reads through a model of the Cortex-M7's data cache (32 KB, 4-way
+ *  set associative, 32 byte lines, LRU) and reports the misses per timeslot.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_bench_layout -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+static std::vector<std::vector<int16_t> > slots;  // Timeslots of audio under test
+
+static const int kPlanar_row_bytes = (ft8_buffer + 31) & ~31;
+
+/**
+ * @brief LRU model of the Cortex-M7 data cache
+ */
+class CacheModel {
+   public:
+    CacheModel() : misses(0), clock(0) { memset(tags, 0xFF, sizeof(tags)); }
+
+    void read(const void* address, int bytes) {
+        uintptr_t first = (uintptr_t)address >> kLine_bits;
+        uintptr_t last = ((uintptr_t)address + bytes - 1) >> kLine_bits;
+        for (uintptr_t line = first; line <= last; ++line) touch(line);
+    }
+
+    unsigned long misses;
+
+   private:
+    static const int kLine_bits = 5;  // 32 byte lines
+    static const int kSets = 256;     // 32 KB / 32 bytes / 4 ways
+    static const int kWays = 4;
+
+    void touch(uintptr_t line) {
+        uintptr_t* set = tags[line % kSets];
+        unsigned long* used = last_used[line % kSets];
+        int victim = 0;
+        for (int w = 0; w < kWays; ++w) {
+            if (set[w] == line) {
+                used[w] = ++clock;
+                return;
+            }
+            if (used[w] < used[victim]) victim = w;
+        }
+        misses++;
+        set[victim] = line;
+        used[victim] = ++clock;
+    }
+
+    uintptr_t tags[kSets][kWays];
+    unsigned long last_used[kSets][kWays] = {};
+    unsigned long clock;
+};
+
+// Per-layout results accumulated over all timeslots
+struct LayoutStats {
+    double sync_ns;
+    double likelihood_ns;
+    unsigned long sync_misses;
+    unsigned long likelihood_misses;
+};
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief Replay find_sync()'s spectrogram reads
+ */
+static void trace_sync(const PowerBytes& power, CacheModel& cache) {
+    for (int alt = 0; alt < 4; ++alt) {
+        for (int time_offset = -7; time_offset < ft8_msg_samples - NN + 7; ++time_offset) {
+            for (int freq_offset = ft8_min_bin; freq_offset < ft8_buffer - 8; ++freq_offset) {
+                for (int m = 0; m <= 72; m += 36) {
+                    for (int k = 0; k < 7; ++k) {
+                        if (time_offset + k + m < 0) continue;
+                        if (time_offset + k + m >= ft8_msg_samples) break;
+                        cache.read(power.at(time_offset + k + m, alt, freq_offset), 8);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Replay extract_likelihood()'s spectrogram reads for one candidate
+ */
+static void trace_likelihood(const PowerBytes& power, const Candidate& cand, CacheModel& cache) {
+    for (int k = 0; k < ND; ++k) {
+        int sym_idx = (k < ND / 2) ? (k + 7) : (k + 14);
+        cache.read(power.at(cand.time_offset + sym_idx, cand.time_sub * 2 + cand.freq_sub, cand.freq_offset), 8);
+    }
+}
+
+/**
+ * @brief Search and demodulate one spectrogram layout
+ */
+static int run_layout(const PowerBytes& power, Candidate* candidates, LayoutStats& stats) {
+    BenchTimer ts;
+    int num_candidates = find_sync(power, ft8_msg_samples, ft8_buffer, kCostas_map, kBenchMax_candidates, candidates, kBenchMin_score);
+    stats.sync_ns += ts.ns();
+
+    float log174[N];
+    BenchTimer tl;
+    for (int i = 0; i < num_candidates; ++i) extract_likelihood(power, ft8_buffer, candidates[i], kGray_map, log174);
+    stats.likelihood_ns += tl.ns();
+
+    CacheModel sync_cache, likelihood_cache;
+    trace_sync(power, sync_cache);
+    for (int i = 0; i < num_candidates; ++i) trace_likelihood(power, candidates[i], likelihood_cache);
+    stats.sync_misses += sync_cache.misses;
+    stats.likelihood_misses += likelihood_cache.misses;
+    return num_candidates;
+}
+
+static void report(const char* title, const LayoutStats& s, int num_slots) {
+    printf("%s\n", title);
+    printf("  find_sync          %12.0f ns/timeslot %10lu simulated D-cache misses/timeslot\n", s.sync_ns / num_slots, s.sync_misses / num_slots);
+    printf("  extract_likelihood %12.0f ns/timeslot %10lu simulated D-cache misses/timeslot\n", s.likelihood_ns / num_slots,
+           s.likelihood_misses / num_slots);
+}
+
+/**
+ * @brief Both layouts find the same candidates; compare their costs
+ */
+void test_bench_layouts(void) {
+#if SPECTROGRAM_4BIT
+    TEST_IGNORE_MESSAGE("Copies the one byte spectrogram, build without SPECTROGRAM_4BIT");
+#endif
+    std::vector<uint8_t> interleaved(ft8_msg_samples * 4 * ft8_buffer);
+    std::vector<uint8_t> planar(ft8_msg_samples * 4 * kPlanar_row_bytes);
+    PowerBytes interleaved_power = {&interleaved[0], 4 * ft8_buffer, ft8_buffer};
+    PowerBytes planar_power = {&planar[0], kPlanar_row_bytes, ft8_msg_samples * kPlanar_row_bytes};
+    LayoutStats interleaved_stats = {0, 0, 0, 0};
+    LayoutStats planar_stats = {0, 0, 0, 0};
+    BenchStats spectrum_stats;
+
+    for (size_t s = 0; s < slots.size(); ++s) {
+        bench_build_spectrogram(slots[s], spectrum_stats);
+        const uint8_t* power = decode_spectrogram();
+        int row_bytes = spectrogram_row_bytes(ft8_buffer);
+        PowerBytes built = {power, spectrogram_time_rows * row_bytes, spectrogram_alt_rows * row_bytes};
+        for (int block = 0; block < ft8_msg_samples; ++block) {
+            for (int alt = 0; alt < 4; ++alt) {
+                memcpy((uint8_t*)interleaved_power.at(block, alt, 0), built.at(block, alt, 0), ft8_buffer);
+                memcpy((uint8_t*)planar_power.at(block, alt, 0), built.at(block, alt, 0), ft8_buffer);
+            }
+        }
+        release_spectrogram(power);
+
+        Candidate interleaved_candidates[kBenchMax_candidates];
+        Candidate planar_candidates[kBenchMax_candidates];
+        int n = run_layout(interleaved_power, interleaved_candidates, interleaved_stats);
+        TEST_ASSERT_EQUAL_INT(n, run_layout(planar_power, planar_candidates, planar_stats));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(interleaved_candidates, planar_candidates, n * sizeof(Candidate));
+    }
+
+    printf("Layouts over %u timeslots (this build uses SPECTROGRAM_PLANAR=%d):\n", (unsigned)slots.size(), SPECTROGRAM_PLANAR);
+    report("Interleaved rows ((block * 4 + alt) * 400 + bin):", interleaved_stats, slots.size());
+    report("Planar rows ((alt * 92 + block) * 416 + bin):", planar_stats, slots.size());
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+    bench_load_slots(slots);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_layouts);
+    return UNITY_END();
+}
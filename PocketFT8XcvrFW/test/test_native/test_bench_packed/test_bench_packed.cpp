@@ -0,0 +1,69 @@
+/**
+ * @brief Host benchmark of the compact 4-bit spectrogram (SPECTROGRAM_4BIT)
+ *
+ * DISCUSSION:
+ *  Each timeslot's spectrogram is built in the one byte format, then packed row by row
+ *  with pack_power_row() exactly as extract_power() does when SPECTROGRAM_4BIT is set.
+ *  Both are decoded and the benchmark reports the storage size, the decoder's time and
+ *  the number of messages decoded from each, i.e. what the 56% smaller store costs in
+ *  unpacking and in sensitivity.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_bench_packed -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+static std::vector<std::vector<int16_t> > slots;  // Timeslots of audio under test
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief Decode every timeslot from both storage formats
+ */
+void test_bench_packed(void) {
+#if SPECTROGRAM_4BIT
+    TEST_IGNORE_MESSAGE("Packs the one byte spectrogram, build without SPECTROGRAM_4BIT");
+#endif
+    BenchStats byte_stats, packed_stats;
+    std::vector<PackedRow> packed(ft8_msg_samples * 4);
+    for (size_t s = 0; s < slots.size(); ++s) {
+        bench_build_spectrogram(slots[s], byte_stats);
+        const uint8_t* power = decode_spectrogram();
+
+        BenchTimer t;
+        for (int row = 0; row < ft8_msg_samples * 4; ++row) pack_power_row(&power[row * spectrogram_row_bytes(ft8_buffer)], &packed[row]);
+        packed_stats.spectrum_ns += t.ns();
+
+        printf("Timeslot %u, one byte entries:\n", (unsigned)s);
+        bench_decode_spectrogram(power, byte_stats, true);
+        printf("Timeslot %u, 4-bit entries:\n", (unsigned)s);
+        bench_decode_spectrogram(&packed[0], packed_stats, true);
+        release_spectrogram(power);
+        byte_stats.slots++;
+        packed_stats.slots++;
+    }
+    packed_stats.spectrum_ns += byte_stats.spectrum_ns;  // Packing adds to the same front end
+
+    printf("\nStorage:  %u bytes/timeslot one byte entries, %u bytes/timeslot 4-bit entries\n", (unsigned)kBenchSpectrogramSize,
+           (unsigned)(ft8_msg_samples * 4 * sizeof(PackedRow)));
+    bench_report("One byte entries (RAM2)", byte_stats);
+    bench_report("4-bit entries (RAM1)", packed_stats);
+
+    // The strong synthetic signals must survive the compression
+    TEST_ASSERT_GREATER_THAN_INT(0, packed_stats.decodes);
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+    bench_load_slots(slots);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_packed);
+    return UNITY_END();
+}
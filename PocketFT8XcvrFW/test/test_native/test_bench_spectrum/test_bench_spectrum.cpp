@@ -0,0 +1,143 @@
+/**
+ * @brief Host benchmark of the band-limited spectral front end
+ *
+ * DISCUSSION:
+ *  find_sync(), extract_likelihood() and the waterfall only read spectrogram columns
+ *  ft8_min_bin..ft8_buffer-1, so extract_power() scales, squares and takes the log of just
+ *  the FFT bins feeding them.  This benchmark replays a timeslot through the original
+ *  full-band front end (every one of the 1024 bins, float window and log()) and through
+ *  the band-limited one, requires identical spectrogram columns in the decoded band, and
+ *  reports each stage's cost per symbol.
+ *
+ *  The host's arm_rfft_q15() computes in double precision, so its share of the total is
+ *  not representative of the Cortex-M7; compare the stages around it.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_bench_spectrum -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+extern arm_rfft_instance_q15 fft_inst;  // See src/Process_DSP.cpp
+extern float window[];
+extern q15_t dsp_output[];
+extern q15_t FFT_Scale[];
+extern q15_t FFT_Magnitude[];
+extern float mag_db[];
+
+static std::vector<int16_t> samples;  // One timeslot of synthetic traffic
+
+// Per-symbol timings accumulated over the timeslot
+struct SpectrumStats {
+    double window_ns;
+    double fft_ns;
+    double band_ns;  // Shift, squared magnitude and log power
+};
+
+void setUp(void) {
+    memset(audio_ring, 0, sizeof(audio_ring));
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief Append the next gulp of the timeslot to the audio ring as process_data() does
+ */
+static void ingest_gulp(int gulp) {
+    for (int b = 0; b < num_que_blocks; ++b) ingest_audio_block(&samples[(size_t)gulp * input_gulp_size + b * block_size]);
+}
+
+/**
+ * @brief The original extract_power():  float window and every bin of the full 2048 point FFT
+ */
+static void full_band_power(uint8_t* symbol, SpectrumStats& stats) {
+    for (int time_sub = 0; time_sub <= input_gulp_size / 2; time_sub += input_gulp_size / 2) {
+        BenchTimer t;
+        window_audio_float(time_sub);
+        stats.window_ns += t.ns();
+
+        t = BenchTimer();
+        arm_rfft_q15(&fft_inst, window_dsp_buffer, dsp_output);
+        stats.fft_ns += t.ns();
+
+        t = BenchTimer();
+        arm_shift_q15(&dsp_output[0], 5, &FFT_Scale[0], FFT_SIZE * 2);
+        arm_cmplx_mag_squared_q15(&FFT_Scale[0], &FFT_Magnitude[0], FFT_SIZE);
+        for (int j = 0; j < FFT_SIZE / 2; j++) mag_db[j] = 5.0 * log((float)(10 * (int32_t)FFT_Magnitude[j]) + 0.1);
+        for (int freq_sub = 0; freq_sub < 2; ++freq_sub) {
+            for (int j = 0; j < ft8_buffer; ++j) {
+                int scaled = (int)((mag_db[j * 2 + freq_sub] + mag_db[j * 2 + freq_sub + 1]) / 2);
+                *symbol++ = (scaled < 0) ? 0 : ((scaled > 255) ? 255 : scaled);
+            }
+        }
+        stats.band_ns += t.ns();
+    }
+}
+
+/**
+ * @brief The band-limited stages of extract_power() with the float window and log()
+ */
+static void band_limited_power(uint8_t* symbol, SpectrumStats& stats) {
+    for (int time_sub = 0; time_sub <= input_gulp_size / 2; time_sub += input_gulp_size / 2) {
+        BenchTimer t;
+        window_audio_float(time_sub);
+        stats.window_ns += t.ns();
+
+        t = BenchTimer();
+        arm_rfft_q15(&fft_inst, window_dsp_buffer, dsp_output);
+        stats.fft_ns += t.ns();
+
+        t = BenchTimer();
+        arm_shift_q15(&dsp_output[2 * ft8_first_fft_bin], 5, &FFT_Scale[2 * ft8_first_fft_bin], 2 * ft8_fft_bins);
+        arm_cmplx_mag_squared_q15(&FFT_Scale[2 * ft8_first_fft_bin], &FFT_Magnitude[ft8_first_fft_bin], ft8_fft_bins);
+        log_power_float(FFT_Magnitude, symbol, ft8_buffer);
+        stats.band_ns += t.ns();
+        symbol += 2 * ft8_buffer;
+    }
+}
+
+static void report(const char* title, const SpectrumStats& s) {
+    printf("%s\n", title);
+    printf("  window             %10.0f ns/symbol\n", s.window_ns / ft8_msg_samples);
+    printf("  arm_rfft_q15       %10.0f ns/symbol\n", s.fft_ns / ft8_msg_samples);
+    printf("  shift+mag+log      %10.0f ns/symbol\n", s.band_ns / ft8_msg_samples);
+}
+
+/**
+ * @brief Band-limited and full-band spectrograms agree in the decoded band; compare their costs
+ */
+void test_bench_band_limited(void) {
+    std::vector<uint8_t> full(kBenchSpectrogramSize);
+    std::vector<uint8_t> band(kBenchSpectrogramSize);
+    SpectrumStats full_stats = {0, 0, 0};
+    SpectrumStats band_stats = {0, 0, 0};
+    SpectrumStats extract_stats = {0, 0, 0};
+    for (int gulp = 0; gulp < ft8_msg_samples; ++gulp) {
+        ingest_gulp(gulp);
+        full_band_power(&full[4 * ft8_buffer * gulp], full_stats);
+        band_limited_power(&band[4 * ft8_buffer * gulp], band_stats);
+
+        BenchTimer t;
+        extract_power(offset_step * gulp);  // As configured by DSP_FIXED_POINT
+        extract_stats.band_ns += t.ns();
+    }
+
+    report("Full-band front end (original):", full_stats);
+    report("Band-limited front end (float):", band_stats);
+    printf("extract_power() as configured (DSP_FIXED_POINT=%d): %.0f ns/symbol\n", DSP_FIXED_POINT, extract_stats.band_ns / ft8_msg_samples);
+
+    for (int row = 0; row < ft8_msg_samples * 4; ++row) {
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(&full[row * ft8_buffer + ft8_min_bin], &band[row * ft8_buffer + ft8_min_bin], ft8_buffer - ft8_min_bin);
+    }
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+    bench_synthesize_slot(2, samples);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_band_limited);
+    return UNITY_END();
+}
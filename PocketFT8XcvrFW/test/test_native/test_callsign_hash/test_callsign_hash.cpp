@@ -0,0 +1,180 @@
+/**
+ * @brief Host tests of the heap-free hashed callsign table
+ *
+ * DISCUSSION:
+ *  ft8_lib saves every callsign it packs or unpacks by its 22-bit hash and looks up
+ *  <hashed> callsigns by 10, 12 or 22-bit hashes.  The table must find callsigns by each
+ *  key length, keep distinct 22-bit keys that share their top 10 bits, leave itself
+ *  unchanged on a miss and evict the least recently used entry once full.  A random
+ *  workload confined to a few home slots (long probe runs, many evictions) is checked
+ *  against a simple reference model.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_callsign_hash -v
+ */
+#include <unity.h>
+
+#include <vector>
+
+#include "ft8_bench.h"
+
+static const int kEntries = 384;  // kHashed_callsign_entries
+
+void setUp(void) {
+    clearHashedCallsignTable();
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief Exact 10, 12 and 22-bit lookups, and a miss adds nothing
+ */
+void test_callsign_hash_lookup(void) {
+    char c11[12];
+    saveHashedCallsign("K1ABC", 0x2A5F3C);
+    saveHashedCallsign("W9XYZ", 0x2A5123);  // Same top 10 bits, different 12 and 22-bit keys
+    TEST_ASSERT_EQUAL_UINT32(2, getHashedCallsignTableSize());
+
+    TEST_ASSERT_TRUE(lookupHashedCallsign(22, 0x2A5F3C, c11));
+    TEST_ASSERT_EQUAL_STRING("K1ABC", c11);
+    TEST_ASSERT_TRUE(lookupHashedCallsign(22, 0x2A5123, c11));
+    TEST_ASSERT_EQUAL_STRING("W9XYZ", c11);
+    TEST_ASSERT_TRUE(lookupHashedCallsign(12, 0x2A5F3C >> 10, c11));
+    TEST_ASSERT_EQUAL_STRING("K1ABC", c11);
+    TEST_ASSERT_TRUE(lookupHashedCallsign(12, 0x2A5123 >> 10, c11));
+    TEST_ASSERT_EQUAL_STRING("W9XYZ", c11);
+
+    // Both share the 10-bit key:  the most recently used wins
+    TEST_ASSERT_TRUE(lookupHashedCallsign(10, 0x2A5F3C >> 12, c11));
+    TEST_ASSERT_EQUAL_STRING("W9XYZ", c11);
+
+    TEST_ASSERT_FALSE(lookupHashedCallsign(22, 0x2A5F3D, c11));
+    TEST_ASSERT_FALSE(lookupHashedCallsign(12, 0x123, c11));
+    TEST_ASSERT_FALSE(lookupHashedCallsign(10, 0x3FF, c11));
+    TEST_ASSERT_FALSE(lookupHashedCallsign(7, 0x2A, c11));
+
+    HashedCallsignStats stats;
+    TEST_ASSERT_EQUAL_UINT32(2, getHashedCallsignTableSize(&stats));
+    TEST_ASSERT_EQUAL_UINT32(5, stats.hits);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.misses);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.evictions);
+
+    // Saving a key again replaces its callsign
+    saveHashedCallsign("K1ABC/P", 0x2A5F3C);
+    TEST_ASSERT_TRUE(lookupHashedCallsign(22, 0x2A5F3C, c11));
+    TEST_ASSERT_EQUAL_STRING("K1ABC/P", c11);
+    TEST_ASSERT_EQUAL_UINT32(2, getHashedCallsignTableSize());
+}
+
+/**
+ * @brief A full table evicts its least recently used entries
+ */
+void test_callsign_hash_eviction(void) {
+    char c11[12], call[12];
+    for (int i = 0; i < kEntries + 100; ++i) {
+        snprintf(call, sizeof(call), "T%dST", i);
+        saveHashedCallsign(call, (uint32_t)i * 0x2F1 + 7);
+        if (i >= 10 && i < kEntries) TEST_ASSERT_TRUE(lookupHashedCallsign(22, 7, c11));  // Keep entry 0 in use
+    }
+
+    HashedCallsignStats stats;
+    TEST_ASSERT_EQUAL_UINT32(kEntries, getHashedCallsignTableSize(&stats));
+    TEST_ASSERT_EQUAL_UINT32(100, stats.evictions);
+
+    TEST_ASSERT_TRUE(lookupHashedCallsign(22, 7, c11));
+    TEST_ASSERT_EQUAL_STRING("T0ST", c11);
+    for (int i = 1; i <= 100; ++i) TEST_ASSERT_FALSE(lookupHashedCallsign(22, (uint32_t)i * 0x2F1 + 7, c11));
+    for (int i = 101; i < kEntries + 100; ++i) {
+        snprintf(call, sizeof(call), "T%dST", i);
+        TEST_ASSERT_TRUE(lookupHashedCallsign(22, (uint32_t)i * 0x2F1 + 7, c11));
+        TEST_ASSERT_EQUAL_STRING(call, c11);
+    }
+}
+
+/**
+ * @brief Random saves and lookups crowded onto a few home slots behave as a reference LRU map
+ */
+void test_callsign_hash_model(void) {
+    struct Entry {
+        uint32_t key22;
+        uint32_t last_used;
+        char callsign[12];
+    };
+    std::vector<Entry> model;
+    uint32_t clock = 0;
+    BenchNoise noise(0x20);
+
+    for (int op = 0; op < 50000; ++op) {
+        // Keys from 16 consecutive 10-bit homes, so probe runs are long and wrap the table's end
+        uint32_t key22 = ((uint32_t)(1008 + 16 * noise.uniform()) & 0x3FF) << 12 | (uint32_t)(4096 * noise.uniform());
+        if (noise.uniform() < 0.6) {
+            char call[12];
+            snprintf(call, sizeof(call), "C%u", (unsigned)op);
+            saveHashedCallsign(call, key22);
+
+            size_t i = 0;
+            while (i < model.size() && model[i].key22 != key22) ++i;
+            if (i == model.size()) {
+                if ((int)model.size() >= kEntries) {
+                    size_t lru = 0;
+                    for (size_t j = 1; j < model.size(); ++j) {
+                        if (model[j].last_used < model[lru].last_used) lru = j;
+                    }
+                    model.erase(model.begin() + lru);
+                }
+                model.push_back(Entry());
+                i = model.size() - 1;
+                model[i].key22 = key22;
+            }
+            strcpy(model[i].callsign, call);
+            model[i].last_used = ++clock;
+        } else {
+            static const int kBits[3] = {10, 12, 22};
+            int bits = kBits[op % 3];
+            uint32_t key = key22 >> (22 - bits);
+
+            int best = -1;
+            for (size_t j = 0; j < model.size(); ++j) {
+                if ((model[j].key22 >> (22 - bits)) == key && (best < 0 || model[j].last_used > model[best].last_used)) best = (int)j;
+            }
+            char c11[12];
+            bool found = lookupHashedCallsign(bits, key, c11);
+            TEST_ASSERT_EQUAL_INT(best >= 0, found);
+            if (best >= 0) {
+                TEST_ASSERT_EQUAL_STRING(model[best].callsign, c11);
+                model[best].last_used = ++clock;
+            }
+        }
+        TEST_ASSERT_EQUAL_UINT32(model.size(), getHashedCallsignTableSize());
+    }
+}
+
+/**
+ * @brief ft8_lib resolves a <hashed> callsign once it has been packed or heard
+ */
+void test_callsign_hash_ft8_lib(void) {
+    uint8_t a77[K_BYTES];
+    char field1[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE], field2[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE], field3[FTX_REPORTS_BFRSIZE];
+    MsgType msgType;
+
+    TEST_ASSERT_EQUAL_INT(0, pack77("W9XYZ PJ4/K1ABC RR73", a77));
+    clearHashedCallsignTable();
+    unpack77_fields(a77, field1, field2, field3, &msgType);
+    TEST_ASSERT_EQUAL_STRING("<...>", field2);
+
+    TEST_ASSERT_EQUAL_INT(0, pack77("W9XYZ PJ4/K1ABC RR73", a77));
+    unpack77_fields(a77, field1, field2, field3, &msgType);
+    TEST_ASSERT_EQUAL_STRING("W9XYZ", field1);
+    TEST_ASSERT_EQUAL_STRING("<PJ4/K1ABC>", field2);
+    TEST_ASSERT_EQUAL_STRING("RR73", field3);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_callsign_hash_lookup);
+    RUN_TEST(test_callsign_hash_eviction);
+    RUN_TEST(test_callsign_hash_model);
+    RUN_TEST(test_callsign_hash_ft8_lib);
+    return UNITY_END();
+}
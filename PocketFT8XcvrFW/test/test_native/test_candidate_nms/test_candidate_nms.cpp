@@ -0,0 +1,97 @@
+/**
+ * @brief Host tests of suppress_candidates()' near-duplicate merging
+ *
+ * DISCUSSION:
+ *  find_sync() often returns several candidates within a step of the same strong signal.
+ *  suppress_candidates() keeps the strongest of each cluster so the LDPC decoder's runs go
+ *  to distinct signals.  These tests check the merging rules on hand-made candidate lists,
+ *  then decode every timeslot with and without suppression and report the LDPC runs saved.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_candidate_nms -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+static std::vector<std::vector<int16_t> > slots;  // Timeslots of audio under test
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static Candidate candidate(int score, int time_offset, int freq_offset, int time_sub, int freq_sub) {
+    Candidate c = {(int16_t)score, (int16_t)time_offset, (int16_t)freq_offset, (uint8_t)time_sub, (uint8_t)freq_sub};
+    return c;
+}
+
+/**
+ * @brief Neighbours within one step of a stronger candidate merge; others survive, strongest first
+ */
+void test_candidate_nms_rules(void) {
+    Candidate list[] = {
+        candidate(50, 10, 200, 0, 0),  // Neighbour of the 90 (one bin up)
+        candidate(90, 10, 199, 0, 0),  // Strong signal
+        candidate(60, 10, 199, 1, 1),  // Neighbour of the 90 (half a step later, half a bin up)
+        candidate(70, 10, 202, 0, 0),  // Distinct signal 3 bins up
+        candidate(45, 13, 199, 0, 0),  // Distinct signal 3 steps later
+        candidate(80, 10, 150, 0, 1),  // Distinct signal
+    };
+    int runs_saved;
+    int n = suppress_candidates(list, 6, 6, &runs_saved);
+    TEST_ASSERT_EQUAL_INT(4, n);
+    TEST_ASSERT_EQUAL_INT(2, runs_saved);
+    TEST_ASSERT_EQUAL_INT(90, list[0].score);
+    TEST_ASSERT_EQUAL_INT(80, list[1].score);
+    TEST_ASSERT_EQUAL_INT(70, list[2].score);
+    TEST_ASSERT_EQUAL_INT(45, list[3].score);
+
+    // Only duplicates ranked among the top max_kept would have been decoded
+    Candidate crowded[] = {
+        candidate(90, 0, 100, 0, 0), candidate(89, 0, 101, 0, 0), candidate(88, 0, 140, 0, 0),
+        candidate(87, 0, 180, 0, 0), candidate(86, 0, 181, 0, 0),
+    };
+    n = suppress_candidates(crowded, 5, 2, &runs_saved);
+    TEST_ASSERT_EQUAL_INT(2, n);
+    TEST_ASSERT_EQUAL_INT(1, runs_saved);
+    TEST_ASSERT_EQUAL_INT(140, crowded[1].freq_offset);
+}
+
+/**
+ * @brief Suppression decodes at least as many messages, and reports the runs it saved
+ */
+void test_candidate_nms_timeslots(void) {
+    BenchStats plain, suppressed;
+    for (size_t s = 0; s < slots.size(); ++s) {
+        BenchStats spectrum;
+        bench_build_spectrogram(slots[s], spectrum);
+        const uint8_t* power = decode_spectrogram();
+#if SPECTROGRAM_4BIT
+        bench_decode_spectrogram((const PackedRow*)power, plain, false, kSync_exhaustive, false);
+        bench_decode_spectrogram((const PackedRow*)power, suppressed, false, kSync_exhaustive, true);
+#else
+        bench_decode_spectrogram(power, plain, false, kSync_exhaustive, false);
+        bench_decode_spectrogram(power, suppressed, false, kSync_exhaustive, true);
+#endif
+        release_spectrogram(power);
+        plain.slots++;
+        suppressed.slots++;
+    }
+    bench_report("Top candidates", plain);
+    bench_report("Suppressed near-duplicates", suppressed);
+
+    TEST_ASSERT_GREATER_THAN_INT(0, suppressed.ldpc_runs_saved);
+    TEST_ASSERT_GREATER_THAN_INT(plain.decodes - 1, suppressed.decodes);
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+    bench_load_slots(slots);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_candidate_nms_rules);
+    RUN_TEST(test_candidate_nms_timeslots);
+    return UNITY_END();
+}
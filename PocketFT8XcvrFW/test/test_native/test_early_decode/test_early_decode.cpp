@@ -0,0 +1,113 @@
+/**
+ * @brief Host tests of the early decoding pass over a partly received timeslot
+ *
+ * DISCUSSION:
+ *  ft8_decode_early() runs find_sync() and the LDPC decoder over the first config.earlyDecode
+ *  symbols of the spectrogram while the rest of the timeslot is still arriving, erasing the
+ *  last few data symbols of signals that haven't finished.  Its decodes must depend only on the
+ *  symbols received, since the bank's later rows still hold an older timeslot, and must be
+ *  messages the full pass would decode too.  The test checks both and reports how many of the
+ *  full pass's messages each early pass length finds:  at the default 74 symbols (11.84 S)
+ *  signals that began on time lack a data symbol, and without the erasures none decoded.
+ *
+ *  The native_multi_symbol environment reruns the test with 2-symbol demodulation, whose groups
+ *  the erasures cut short at the last symbol received.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_early_decode -v
+ *  pio test -e native_multi_symbol -f test_native/test_early_decode -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+static std::vector<std::vector<int16_t> > slots;  // Timeslots of audio under test
+
+static const int kEarly_symbols[] = {72, 74, 76, 78, 80, 84};
+static const int kDefault_early_symbols = 74;  // DEFAULT_EARLY_DECODE
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Decode the first num_blocks symbols of the spectrogram built from samples
+static int decode_slot(const std::vector<int16_t>& samples, int num_blocks, BenchStats& stats, PayloadSet* payloads) {
+    BenchStats spectrum;
+    bench_build_spectrogram(samples, spectrum);
+    const uint8_t* power = decode_spectrogram();
+#if SPECTROGRAM_4BIT
+    int decodes = bench_decode_spectrogram((const PackedRow*)power, stats, false, kSync_exhaustive, true, num_blocks, payloads);
+#else
+    int decodes = bench_decode_spectrogram(power, stats, false, kSync_exhaustive, true, num_blocks, payloads);
+#endif
+    release_spectrogram(power);
+    stats.slots++;
+    return decodes;
+}
+
+// Whether every payload in subset is also in set
+static bool payloads_within(const PayloadSet& subset, const PayloadSet& set) {
+    for (int i = 0; i < kPayload_set_slots; ++i) {
+        if (!subset.used[i]) continue;
+        uint8_t a91[12];
+        for (int w = 0; w < 3; ++w) {
+            for (int b = 0; b < 4; ++b) a91[4 * w + b] = (uint8_t)(subset.key[i][w] >> (24 - 8 * b));
+        }
+        PayloadSet probe = set;
+        if (payload_set_insert(probe, a91)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief An early pass reads none of the symbols that haven't arrived
+ */
+void test_early_decode_causal(void) {
+    for (size_t s = 0; s < slots.size(); ++s) {
+        // Silence everything after the early pass's symbols, as though they hadn't been received
+        std::vector<int16_t> partial(slots[s]);
+        for (size_t n = (size_t)kDefault_early_symbols * input_gulp_size; n < partial.size(); ++n) partial[n] = 0;
+
+        BenchStats whole_stats, partial_stats;
+        PayloadSet whole, truncated;
+        int whole_decodes = decode_slot(slots[s], kDefault_early_symbols, whole_stats, &whole);
+        int partial_decodes = decode_slot(partial, kDefault_early_symbols, partial_stats, &truncated);
+        TEST_ASSERT_EQUAL_INT(whole_decodes, partial_decodes);
+        TEST_ASSERT_EQUAL_INT(whole_stats.candidates, partial_stats.candidates);
+        TEST_ASSERT_EQUAL_INT(whole_stats.ldpc_iterations, partial_stats.ldpc_iterations);
+        TEST_ASSERT_TRUE(payloads_within(whole, truncated));
+    }
+}
+
+/**
+ * @brief Early passes decode only messages the full pass decodes, and how many of them
+ */
+void test_early_decode_yield(void) {
+    BenchStats full;
+    std::vector<PayloadSet> full_payloads(slots.size());
+    for (size_t s = 0; s < slots.size(); ++s) decode_slot(slots[s], ft8_msg_samples, full, &full_payloads[s]);
+
+    for (unsigned e = 0; e < sizeof(kEarly_symbols) / sizeof(kEarly_symbols[0]); ++e) {
+        BenchStats early;
+        for (size_t s = 0; s < slots.size(); ++s) {
+            PayloadSet payloads;
+            decode_slot(slots[s], kEarly_symbols[e], early, &payloads);
+            TEST_ASSERT_TRUE(payloads_within(payloads, full_payloads[s]));
+        }
+        printf("Early pass after %d symbols (%.2f S):  %d of %d decodes, %.0f ns/timeslot find_sync, %d candidates\n", kEarly_symbols[e],
+               kEarly_symbols[e] * 0.16, early.decodes, full.decodes, early.sync_ns / early.slots, early.candidates);
+        if (kEarly_symbols[e] == kDefault_early_symbols) TEST_ASSERT_GREATER_THAN_INT(full.decodes / 2, early.decodes);
+    }
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+    bench_load_slots(slots);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_early_decode_causal);
+    RUN_TEST(test_early_decode_yield);
+    return UNITY_END();
+}
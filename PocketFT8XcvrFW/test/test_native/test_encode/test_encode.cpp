@@ -0,0 +1,165 @@
+/**
+ * @brief Host tests and micro-benchmark of the table-driven CRC-14 and word-wise LDPC encoder
+ *
+ * DISCUSSION:
+ *  crc() divides a byte at a time with kCRC14_table and encode174() XORs precomputed generator
+ *  columns 32 parity bits at a time.  Both are checked against golden vectors (computed with
+ *  the bit-serial algorithms) and, over random messages and bit counts, against copies of the
+ *  bit-serial crc() and the parity8() encoder they replaced.  The test then reports the cost
+ *  of each old and new function.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_encode -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// The bit-at-a-time crc() it replaced
+static uint16_t reference_crc(const uint8_t* message, int num_bits) {
+    uint16_t TOPBIT = (1 << (CRC_WIDTH - 1));
+    uint16_t remainder = 0;
+    int idx_byte = 0;
+    for (int idx_bit = 0; idx_bit < num_bits; ++idx_bit) {
+        if (idx_bit % 8 == 0) {
+            remainder ^= (message[idx_byte] << (CRC_WIDTH - 8));
+            ++idx_byte;
+        }
+        if (remainder & TOPBIT) {
+            remainder = (remainder << 1) ^ CRC_POLYNOMIAL;
+        } else {
+            remainder = (remainder << 1);
+        }
+    }
+    return remainder & ((1 << CRC_WIDTH) - 1);
+}
+
+static uint8_t reference_parity8(uint8_t x) {
+    x ^= x >> 4;
+    x ^= x >> 2;
+    x ^= x >> 1;
+    return (x) & 1;
+}
+
+// The row-at-a-time encode174() it replaced
+static void reference_encode174(const uint8_t* message, uint8_t* codeword) {
+    for (int j = 0; j < (7 + N) / 8; ++j) {
+        codeword[j] = (j < K_BYTES) ? message[j] : 0;
+    }
+    uint8_t col_mask = (0x80 >> (K % 8));
+    uint8_t col_idx = K_BYTES - 1;
+    for (int i = 0; i < M; ++i) {
+        uint8_t nsum = 0;
+        for (int j = 0; j < K_BYTES; ++j) {
+            nsum ^= reference_parity8(message[j] & kGenerator[i][j]);
+        }
+        if (nsum % 2) codeword[col_idx] |= col_mask;
+        col_mask >>= 1;
+        if (col_mask == 0) {
+            col_mask = 0x80;
+            ++col_idx;
+        }
+    }
+}
+
+static void random_message(BenchNoise& noise, uint8_t message[]) {
+    for (int j = 0; j < K_BYTES; ++j) message[j] = (uint8_t)(256 * noise.uniform());
+    message[K_BYTES - 1] &= 0xE0;  // 91 bits
+}
+
+/**
+ * @brief Golden payloads, their CRCs and codewords
+ */
+void test_encode_golden(void) {
+    static const uint8_t kPayload[3][10] = {
+        {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
+        {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a},
+        {0x00, 0x00, 0x00, 0x20, 0x4c, 0x9a, 0x9a, 0xa8, 0x9c, 0x58}};
+    static const uint16_t kCRC[3] = {0x07b1, 0x1706, 0x05bd};
+    static const uint8_t kCodeword[3][22] = {
+        {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf6, 0x3f, 0xb5, 0xaf, 0x2e, 0xc4, 0xe7, 0x67, 0xe6, 0x27, 0xcf, 0x54},
+        {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0xe0, 0xcb, 0xb1, 0xfe, 0x8d, 0xf8, 0xfa, 0xc4, 0x46, 0xdb, 0x61, 0xb8},
+        {0x00, 0x00, 0x00, 0x20, 0x4c, 0x9a, 0x9a, 0xa8, 0x9c, 0x58, 0xb7, 0xbf, 0xb1, 0xbf, 0xe8, 0xa9, 0xf0, 0x61, 0x95, 0x7d, 0xf5, 0xc8}};
+
+    for (int v = 0; v < 3; ++v) {
+        uint8_t a91[K_BYTES];
+        memcpy(a91, kPayload[v], 10);
+        a91[10] = a91[11] = 0;
+        a91[9] &= 0xF8;
+        TEST_ASSERT_EQUAL_HEX16(kCRC[v], crc(a91, 96 - 14));
+        bench_add_crc(a91);
+
+        uint8_t codeword[22];
+        encode174(a91, codeword);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(kCodeword[v], codeword, 22);
+    }
+}
+
+/**
+ * @brief crc() and encode174() match the bit-serial versions on random messages and lengths
+ */
+void test_encode_matches_reference(void) {
+    BenchNoise noise(0x19);
+    for (int t = 0; t < 5000; ++t) {
+        uint8_t message[K_BYTES];
+        random_message(noise, message);
+        for (int num_bits = 1; num_bits <= 96; num_bits += 1 + t % 7) {
+            TEST_ASSERT_EQUAL_HEX16(reference_crc(message, num_bits), crc(message, num_bits));
+        }
+
+        uint8_t codeword[22], reference[22];
+        encode174(message, codeword);
+        reference_encode174(message, reference);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(reference, codeword, 22);
+    }
+}
+
+/**
+ * @brief Cost of the old and new crc() and encode174()
+ */
+void test_encode_timing(void) {
+    const int kMessages = 200000;
+    static uint8_t messages[64][12];  // [64][K_BYTES]
+    BenchNoise noise(0x1A);
+    for (int m = 0; m < 64; ++m) random_message(noise, messages[m]);
+    unsigned sink = 0;
+
+    BenchTimer t0;
+    for (int m = 0; m < kMessages; ++m) sink += reference_crc(messages[m & 63], 96 - 14);
+    double old_crc_ns = t0.ns() / kMessages;
+    BenchTimer t1;
+    for (int m = 0; m < kMessages; ++m) sink -= crc(messages[m & 63], 96 - 14);
+    double crc_ns = t1.ns() / kMessages;
+
+    uint8_t codeword[22];
+    BenchTimer t2;
+    for (int m = 0; m < kMessages; ++m) {
+        reference_encode174(messages[m & 63], codeword);
+        sink += codeword[21];
+    }
+    double old_encode_ns = t2.ns() / kMessages;
+    BenchTimer t3;
+    for (int m = 0; m < kMessages; ++m) {
+        encode174(messages[m & 63], codeword);
+        sink -= codeword[21];
+    }
+    double encode_ns = t3.ns() / kMessages;
+
+    printf("crc() bitwise %.1f ns, table %.1f ns (%.1fx)\n", old_crc_ns, crc_ns, old_crc_ns / crc_ns);
+    printf("encode174() parity8 %.1f ns, columns %.1f ns (%.1fx)\n", old_encode_ns, encode_ns, old_encode_ns / encode_ns);
+    TEST_ASSERT_EQUAL_UINT(0, sink);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_encode_golden);
+    RUN_TEST(test_encode_matches_reference);
+    RUN_TEST(test_encode_timing);
+    return UNITY_END();
+}
@@ -0,0 +1,192 @@
+/**
+ * @brief Host test and micro-benchmark of find_sync()'s streaming Costas scorer
+ *
+ * DISCUSSION:
+ *  find_sync() sums the sync rows' bins and expected tones for every freq_offset with
+ *  vectorized passes (FT8_SYNC_SIMD), then slides the 8 bin window along the column sums.
+ *  These tests compare it with the original cell-by-cell scorer (reproduced below) on
+ *  synthetic timeslots and on random spectrograms, requiring the same candidates in the
+ *  same heap order and the same max_score, and report the time each takes per timeslot.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_find_sync -v
+ *  PLATFORMIO_BUILD_FLAGS=-DFT8_SYNC_SIMD=0 pio test -e native -f test_native/test_find_sync -v
+ */
+#include <unity.h>
+
+#include <algorithm>
+
+#include "ft8_bench.h"
+
+extern int max_score;  // See lib/ft8/decode.cpp
+
+static std::vector<std::vector<int16_t> > slots;  // Timeslots of audio under test
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief The original find_sync():  each cell reloads its 8 bins
+ */
+static int reference_find_sync(const PowerBytes& power, int num_blocks, int num_bins, const uint8_t* sync_map, int num_candidates, Candidate* heap,
+                               int min_score, int* reference_max_score) {
+    int heap_size = 0;
+    *reference_max_score = 0;
+    for (int alt = 0; alt < 4; ++alt) {
+        for (int time_offset = -7; time_offset < num_blocks - NN + 7; ++time_offset) {
+            for (int freq_offset = ft8_min_bin; freq_offset < num_bins - 8; ++freq_offset) {
+                int score = 0;
+                int num_symbols = 0;
+                for (int m = 0; m <= 72; m += 36) {
+                    for (int k = 0; k < 7; ++k) {
+                        if (time_offset + k + m < 0) continue;
+                        if (time_offset + k + m >= num_blocks) break;
+                        const uint8_t* p8 = power.at(time_offset + k + m, alt, freq_offset);
+                        score += 8 * p8[sync_map[k]] - p8[0] - p8[1] - p8[2] - p8[3] - p8[4] - p8[5] - p8[6] - p8[7];
+                        ++num_symbols;
+                    }
+                }
+                score /= num_symbols;
+
+                if (score > *reference_max_score) *reference_max_score = score;
+                if (score < min_score) continue;
+
+                // The heap is checked against the production heap, so mirror its bookkeeping exactly
+                if (heap_size == num_candidates && score > heap[0].score) {
+                    heap[0] = heap[heap_size - 1];
+                    --heap_size;
+                    int current = 0;
+                    while (true) {
+                        int smallest = current, left = 2 * current + 1, right = left + 1;
+                        if (left < heap_size && heap[left].score < heap[smallest].score) smallest = left;
+                        if (right < heap_size && heap[right].score < heap[smallest].score) smallest = right;
+                        if (smallest == current) break;
+                        Candidate tmp = heap[smallest];
+                        heap[smallest] = heap[current];
+                        heap[current] = tmp;
+                        current = smallest;
+                    }
+                }
+                if (heap_size < num_candidates) {
+                    Candidate c = {(int16_t)score, (int16_t)time_offset, (int16_t)freq_offset, (uint8_t)(alt / 2), (uint8_t)(alt % 2)};
+                    heap[heap_size++] = c;
+                    for (int current = heap_size - 1; current > 0;) {
+                        int parent = (current - 1) / 2;
+                        if (heap[current].score >= heap[parent].score) break;
+                        Candidate tmp = heap[parent];
+                        heap[parent] = heap[current];
+                        heap[current] = tmp;
+                        current = parent;
+                    }
+                }
+            }
+        }
+    }
+    return heap_size;
+}
+
+/**
+ * @brief Both scorers agree on one spectrogram; accumulate their times
+ */
+static void check_spectrogram(const PowerBytes& power, int num_candidates, int min_score, double* reference_ns, double* streaming_ns) {
+    Candidate expected[kBenchMax_candidates * 4];
+    Candidate actual[kBenchMax_candidates * 4];
+    int expected_max_score;
+
+    BenchTimer tr;
+    int n = reference_find_sync(power, ft8_msg_samples, ft8_buffer, kCostas_map, num_candidates, expected, min_score, &expected_max_score);
+    *reference_ns += tr.ns();
+
+    BenchTimer ts;
+    TEST_ASSERT_EQUAL_INT(n, find_sync(power, ft8_msg_samples, ft8_buffer, kCostas_map, num_candidates, actual, min_score));
+    *streaming_ns += ts.ns();
+
+    TEST_ASSERT_EQUAL_INT(expected_max_score, max_score);
+    for (int i = 0; i < n; ++i) {
+        TEST_ASSERT_EQUAL_INT(expected[i].score, actual[i].score);
+        TEST_ASSERT_EQUAL_INT(expected[i].time_offset, actual[i].time_offset);
+        TEST_ASSERT_EQUAL_INT(expected[i].freq_offset, actual[i].freq_offset);
+        TEST_ASSERT_EQUAL_INT(expected[i].time_sub, actual[i].time_sub);
+        TEST_ASSERT_EQUAL_INT(expected[i].freq_sub, actual[i].freq_sub);
+    }
+}
+
+/**
+ * @brief Identical candidates from real-looking timeslots, with the decoder's and a larger heap
+ */
+void test_find_sync_timeslots(void) {
+    std::vector<uint8_t> power(ft8_msg_samples * 4 * ft8_buffer);
+    PowerBytes bytes = {&power[0], 4 * ft8_buffer, ft8_buffer};
+    double reference_ns = 0, streaming_ns = 0;
+    BenchStats stats;
+    for (size_t s = 0; s < slots.size(); ++s) {
+        bench_build_spectrogram(slots[s], stats);
+        const uint8_t* built = decode_spectrogram();
+#if SPECTROGRAM_4BIT
+        // Unpack the compact rows so the byte kernels are checked too
+        PowerNibbles nibbles = {(const PackedRow*)built};
+        for (int block = 0; block < ft8_msg_samples; ++block) {
+            for (int alt = 0; alt < 4; ++alt) {
+                PackedCursor row = nibbles.at(block, alt, ft8_min_bin);
+                uint8_t* unpacked = &power[(block * 4 + alt) * ft8_buffer];
+                for (int bin = ft8_min_bin; bin < ft8_buffer; ++bin) unpacked[bin] = (uint8_t)std::min(255, row[bin - ft8_min_bin]);
+            }
+        }
+#else
+        int row_bytes = spectrogram_row_bytes(ft8_buffer);
+        for (int block = 0; block < ft8_msg_samples; ++block) {
+            for (int alt = 0; alt < 4; ++alt) {
+                memcpy(&power[(block * 4 + alt) * ft8_buffer], &built[(block * spectrogram_time_rows + alt * spectrogram_alt_rows) * row_bytes], ft8_buffer);
+            }
+        }
+#endif
+
+        check_spectrogram(bytes, kBenchMax_candidates, kBenchMin_score, &reference_ns, &streaming_ns);
+        check_spectrogram(bytes, kBenchMax_candidates * 4, 0, &reference_ns, &streaming_ns);
+
+#if SPECTROGRAM_4BIT
+        // The compact rows, read entry by entry, give the same candidates as their unpacked bytes
+        Candidate expected[kBenchMax_candidates];
+        Candidate actual[kBenchMax_candidates];
+        int n = find_sync(bytes, ft8_msg_samples, ft8_buffer, kCostas_map, kBenchMax_candidates, expected, kBenchMin_score);
+        TEST_ASSERT_EQUAL_INT(n, find_sync((const PackedRow*)built, ft8_msg_samples, ft8_buffer, kCostas_map, kBenchMax_candidates, actual, kBenchMin_score));
+        for (int i = 0; i < n; ++i) {
+            TEST_ASSERT_EQUAL_INT(expected[i].score, actual[i].score);
+            TEST_ASSERT_EQUAL_INT(expected[i].freq_offset, actual[i].freq_offset);
+        }
+#endif
+        release_spectrogram(built);
+    }
+
+    double slots_timed = 2.0 * slots.size();
+    printf("find_sync (FT8_SYNC_SIMD=%d):  cell-by-cell %.0f ns/timeslot, streaming %.0f ns/timeslot, speedup %.2fx\n", FT8_SYNC_SIMD, reference_ns / slots_timed,
+           streaming_ns / slots_timed, reference_ns / streaming_ns);
+}
+
+/**
+ * @brief Identical candidates from random spectrograms, including saturated entries
+ */
+void test_find_sync_random(void) {
+    std::vector<uint8_t> power(ft8_msg_samples * 4 * ft8_buffer);
+    PowerBytes bytes = {&power[0], 4 * ft8_buffer, ft8_buffer};
+    BenchNoise noise(11);
+    double reference_ns = 0, streaming_ns = 0;
+    for (int trial = 0; trial < 3; ++trial) {
+        for (size_t i = 0; i < power.size(); ++i) power[i] = (trial == 2 && i % 7 == 0) ? 255 : (uint8_t)(noise.uniform() * 256);
+        check_spectrogram(bytes, kBenchMax_candidates, kBenchMin_score, &reference_ns, &streaming_ns);
+        check_spectrogram(bytes, kBenchMax_candidates * 4, -1000, &reference_ns, &streaming_ns);
+    }
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+    bench_load_slots(slots);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_find_sync_timeslots);
+    RUN_TEST(test_find_sync_random);
+    return UNITY_END();
+}
@@ -0,0 +1,124 @@
+/**
+ * @brief Host accuracy test of the all-integer spectral front end (DSP_FIXED_POINT)
+ *
+ * DISCUSSION:
+ *  extract_power() may window with a Q15 table and arm_mult_q15() and convert squared
+ *  magnitudes to the uint8 spectrogram scale with a leading-zero count and a log table,
+ *  or use the original float window and log().  One spectrogram unit is 5*ln(x), or
+ *  0.87 dB of power.  Over every possible magnitude, the integer log must never differ from
+ *  the float one by more than a unit.  Over a whole timeslot, where the two windows' rounding
+ *  also differs, entries above the quietest bins must agree within a unit, and the rest are
+ *  judged by the RMS deviation and the number beyond a unit.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_fixed_point -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+extern arm_rfft_instance_q15 fft_inst;  // See src/Process_DSP.cpp
+extern q15_t dsp_output[];
+extern q15_t FFT_Scale[];
+extern q15_t FFT_Magnitude[];
+
+static const double kDB_per_unit = 10 * log10(exp(0.2));  // Power dB per spectrogram unit
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief Every squared magnitude (as both members of a bin pair) converts within one unit
+ */
+void test_log_power_all_magnitudes(void) {
+    static q15_t magnitude[FFT_SIZE];
+    uint8_t row_float[2 * ft8_buffer];
+    uint8_t row_q15[2 * ft8_buffer];
+    int max_diff = 0;
+    for (int32_t base = 0; base < 32768; base += 2 * ft8_buffer + 1) {
+        for (int j = 0; j < FFT_SIZE; j++) magnitude[j] = (q15_t)((base + j < 32768) ? base + j : 32767);
+        log_power_float(magnitude, row_float, ft8_buffer);
+        log_power_q15(magnitude, row_q15, ft8_buffer);
+        for (int j = 0; j < 2 * ft8_buffer; j++) {
+            int diff = abs((int)row_q15[j] - (int)row_float[j]);
+            if (diff > max_diff) max_diff = diff;
+        }
+    }
+    printf("log power:  max deviation %d units (%.2f dB)\n", max_diff, max_diff * kDB_per_unit);
+    TEST_ASSERT_TRUE(max_diff <= 1);
+}
+
+/**
+ * @brief Transform the most recent gulps with either front end into one symbol's spectrogram entries
+ */
+static void transform(bool fixed_point, uint8_t* symbol) {
+    for (int time_sub = 0; time_sub <= input_gulp_size / 2; time_sub += input_gulp_size / 2) {
+        if (fixed_point) {
+            window_audio_q15(time_sub);
+        } else {
+            window_audio_float(time_sub);
+        }
+        arm_rfft_q15(&fft_inst, window_dsp_buffer, dsp_output);
+        arm_shift_q15(&dsp_output[0], 5, &FFT_Scale[0], FFT_SIZE * 2);
+        arm_cmplx_mag_squared_q15(&FFT_Scale[0], &FFT_Magnitude[0], FFT_SIZE);
+        if (fixed_point) {
+            log_power_q15(FFT_Magnitude, symbol, ft8_buffer);
+        } else {
+            log_power_float(FFT_Magnitude, symbol, ft8_buffer);
+        }
+        symbol += 2 * ft8_buffer;
+    }
+}
+
+/**
+ * @brief A timeslot of synthetic FT8 traffic produces spectrograms within 1 dB of each other
+ *
+ * The two windows round differently by an LSB, which the FFT spreads across bins.  Where a
+ * bin's squared magnitude is only a few LSBs that may flip it to or from zero, and 5*ln(x + 0.1)
+ * magnifies the flip into as many as 12 units in either path.  Above kQuiet_entry, where a flip
+ * costs less than a unit, every entry must agree within one.  Over the whole spectrogram, the
+ * RMS deviation must stay under 1 dB and all but 0.1% of entries must agree within one unit.
+ */
+void test_timeslot_spectrogram(void) {
+    std::vector<int16_t> samples;
+    bench_synthesize_slot(5, samples);
+    std::vector<uint8_t> power_float(kBenchSpectrogramSize);
+    std::vector<uint8_t> power_q15(kBenchSpectrogramSize);
+
+    memset(audio_ring, 0, sizeof(audio_ring));
+    for (int gulp = 0; gulp < ft8_msg_samples; ++gulp) {
+        for (int b = 0; b < num_que_blocks; ++b) ingest_audio_block(&samples[(size_t)gulp * input_gulp_size + b * block_size]);
+        transform(false, &power_float[4 * ft8_buffer * gulp]);
+        transform(true, &power_q15[4 * ft8_buffer * gulp]);
+    }
+
+    const int kQuiet_entry = 25;  // 5*ln(10*16):  magnitudes of 16 LSBs and less
+    int max_diff = 0, max_loud_diff = 0, outliers = 0;
+    double sum_diff = 0, sum_squares = 0;
+    for (int i = 0; i < kBenchSpectrogramSize; ++i) {
+        int diff = (int)power_q15[i] - (int)power_float[i];
+        if (abs(diff) > max_diff) max_diff = abs(diff);
+        if (power_float[i] > kQuiet_entry && power_q15[i] > kQuiet_entry && abs(diff) > max_loud_diff) max_loud_diff = abs(diff);
+        if (abs(diff) > 1) outliers++;
+        sum_diff += diff;
+        sum_squares += diff * diff;
+    }
+    double rms_db = sqrt(sum_squares / kBenchSpectrogramSize) * kDB_per_unit;
+    printf("timeslot:  RMS deviation %.3f dB, mean %+.3f units, max %d units (%d above the quiet bins), %d of %d entries beyond 1 unit\n",
+           rms_db, sum_diff / kBenchSpectrogramSize, max_diff, max_loud_diff, outliers, kBenchSpectrogramSize);
+    TEST_ASSERT_TRUE(max_loud_diff <= 1);
+    TEST_ASSERT_TRUE(rms_db < 1.0);
+    TEST_ASSERT_TRUE(outliers * 1000 < kBenchSpectrogramSize);
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_log_power_all_magnitudes);
+    RUN_TEST(test_timeslot_spectrogram);
+    return UNITY_END();
+}
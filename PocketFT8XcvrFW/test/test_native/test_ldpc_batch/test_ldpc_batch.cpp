@@ -0,0 +1,116 @@
+/**
+ * @brief Host tests of the batched structure-of-arrays LDPC decoder
+ *
+ * DISCUSSION:
+ *  bp_decode_batch() must return, lane for lane, exactly what bp_decode() returns for the same
+ *  codeword:  the same plain[], error count and iterations, including for lanes that converge
+ *  or stall before the rest of their batch and for partially filled batches.  The test then
+ *  times both decoders over the same frames and reports the cost per candidate.  No speedup
+ *  is asserted:  none has been measured reliably.  The batch decoder is built only with
+ *  LDPC_BATCH, so without it both tests are ignored.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_ldpc_batch -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+#if LDPC_BATCH
+static const int kFrames = 240;  // A multiple of kLDPC_lanes
+
+static float frames[kFrames][174];
+
+// Weak through strong frames and noise, so lanes end at different iterations
+static void make_frames(void) {
+    BenchNoise noise(17);
+    uint8_t bits[174];
+    for (int f = 0; f < kFrames; ++f) {
+        if (f % 6 == 5) {
+            for (int i = 0; i < N; ++i) frames[f][i] = (float)(4 * noise.gaussian());
+        } else {
+            bench_make_frame(noise, 1.0 + 0.5 * (f % 6), bits, frames[f]);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Every lane matches bp_decode() bit for bit, whatever the batch's size
+ */
+void test_ldpc_batch_matches(void) {
+#if !LDPC_BATCH
+    TEST_IGNORE_MESSAGE("bp_decode_batch() is built only with -D LDPC_BATCH=1");
+#else
+    make_frames();
+    int f = 0, lanes = 1;
+    while (f < kFrames) {
+        LDPCBatch batch;
+        batch.num_lanes = std::min(lanes, kFrames - f);
+        for (int l = 0; l < batch.num_lanes; ++l) batch.codeword[l] = frames[f + l];
+        bp_decode_batch(batch, kBenchLDPC_iterations);
+
+        for (int l = 0; l < batch.num_lanes; ++l) {
+            uint8_t plain[174];
+            int n_errors, iterations;
+            bp_decode(frames[f + l], kBenchLDPC_iterations, plain, &n_errors, &iterations);
+            TEST_ASSERT_EQUAL_INT(n_errors, batch.ok[l]);
+            TEST_ASSERT_EQUAL_INT(iterations, batch.iterations[l]);
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(plain, batch.plain[l], N);
+        }
+        f += batch.num_lanes;
+        lanes = lanes % kLDPC_lanes + 1;
+    }
+#endif
+}
+
+/**
+ * @brief Cost per candidate of bp_decode() and bp_decode_batch()
+ */
+void test_ldpc_batch_timing(void) {
+#if !LDPC_BATCH
+    TEST_IGNORE_MESSAGE("bp_decode_batch() is built only with -D LDPC_BATCH=1");
+#else
+    const int kRepeats = 5;
+    int sink = 0;
+
+    BenchTimer serial;
+    for (int r = 0; r < kRepeats; ++r) {
+        for (int f = 0; f < kFrames; ++f) {
+            uint8_t plain[174];
+            int n_errors;
+            bp_decode(frames[f], kBenchLDPC_iterations, plain, &n_errors);
+            sink += n_errors;
+        }
+    }
+    double serial_ns = serial.ns() / (kRepeats * kFrames);
+
+    BenchTimer batched;
+    for (int r = 0; r < kRepeats; ++r) {
+        for (int f = 0; f < kFrames; f += kLDPC_lanes) {
+            LDPCBatch batch;
+            batch.num_lanes = kLDPC_lanes;
+            for (int l = 0; l < kLDPC_lanes; ++l) batch.codeword[l] = frames[f + l];
+            bp_decode_batch(batch, kBenchLDPC_iterations);
+            for (int l = 0; l < kLDPC_lanes; ++l) sink -= batch.ok[l];
+        }
+    }
+    double batch_ns = batched.ns() / (kRepeats * kFrames);
+
+    printf("bp_decode() %.0f ns/candidate, bp_decode_batch() of %d lanes %.0f ns/candidate (%.2fx)\n", serial_ns, kLDPC_lanes, batch_ns, serial_ns / batch_ns);
+    TEST_ASSERT_EQUAL_INT(0, sink);
+#endif
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ldpc_batch_matches);
+    RUN_TEST(test_ldpc_batch_timing);
+    return UNITY_END();
+}
@@ -0,0 +1,99 @@
+/**
+ * @brief Host comparison of bp_decode()'s flooding schedule with bp_decode_layered()
+ *
+ * DISCUSSION:
+ *  Decodes BPSK/AWGN frames (see bench_make_frame()) with both schedules and reports frame
+ *  error rate and mean iterations against Eb/N0, then decodes the benchmark timeslots (or
+ *  the recordings in FT8_BENCH_WAV_DIR) with each and reports the iterations per candidate.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_ldpc_layered -v
+ *  FT8_BENCH_WAV_DIR=/path/to/recordings pio test -e native -f test_native/test_ldpc_layered -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+static const int kFrames = 300;  // Frames per Eb/N0
+
+static std::vector<std::vector<int16_t> > slots;  // Timeslots of audio under test
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief Frame error rate and iterations against Eb/N0 for both schedules
+ */
+void test_ldpc_layered_fer(void) {
+    const double ebn0_db[] = {1.0, 2.0, 3.0, 4.0};
+    const int num_points = sizeof(ebn0_db) / sizeof(ebn0_db[0]);
+    int flooding_converged_iterations = 0, layered_converged_iterations = 0, both_converged = 0;
+    BenchNoise noise(91);
+
+    printf("Eb/N0   flooding FER iterations   layered FER iterations\n");
+    for (int p = 0; p < num_points; ++p) {
+        int flooding_errors = 0, layered_errors = 0;
+        int flooding_iterations = 0, layered_iterations = 0;
+        for (int frame = 0; frame < kFrames; ++frame) {
+            uint8_t bits[N], plain[N];
+            float log174[N];
+            int n_errors, iterations, layered;
+            bench_make_frame(noise, ebn0_db[p], bits, log174);
+
+            bp_decode(log174, kBenchLDPC_iterations, plain, &n_errors, &iterations);
+            bool flooding_ok = n_errors == 0 && memcmp(bits, plain, N) == 0;
+            flooding_errors += !flooding_ok;
+            flooding_iterations += iterations;
+
+            bp_decode_layered(log174, kBenchLDPC_iterations, plain, &n_errors, &layered);
+            bool layered_ok = n_errors == 0 && memcmp(bits, plain, N) == 0;
+            layered_errors += !layered_ok;
+            layered_iterations += layered;
+
+            if (flooding_ok && layered_ok) {
+                both_converged++;
+                flooding_converged_iterations += iterations;
+                layered_converged_iterations += layered;
+            }
+        }
+        printf("%4.1f dB  %12.3f %10.2f   %11.3f %10.2f\n", ebn0_db[p], (double)flooding_errors / kFrames, (double)flooding_iterations / kFrames,
+               (double)layered_errors / kFrames, (double)layered_iterations / kFrames);
+        TEST_ASSERT_TRUE(layered_errors <= flooding_errors);
+    }
+    printf("Frames both decoded:  flooding %.2f, layered %.2f iterations\n", (double)flooding_converged_iterations / both_converged,
+           (double)layered_converged_iterations / both_converged);
+    TEST_ASSERT_TRUE(layered_converged_iterations < flooding_converged_iterations);
+}
+
+/**
+ * @brief Iterations per candidate on timeslots
+ */
+void test_ldpc_layered_timeslots(void) {
+    BenchStats stats;
+    for (size_t s = 0; s < slots.size(); ++s) {
+        bench_build_spectrogram(slots[s], stats);
+        const uint8_t* power = decode_spectrogram();
+#if SPECTROGRAM_4BIT
+        bench_decode_spectrogram((const PackedRow*)power, stats);
+#else
+        bench_decode_spectrogram(power, stats);
+#endif
+        release_spectrogram(power);
+        stats.slots++;
+    }
+    bench_report(LDPC_LAYERED ? "Layered schedule" : "Flooding schedule (build with -D LDPC_LAYERED=1 for layered)", stats);
+    TEST_ASSERT_GREATER_THAN_INT(0, stats.decodes);
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+    bench_load_slots(slots);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_ldpc_layered_fer);
+    RUN_TEST(test_ldpc_layered_timeslots);
+    return UNITY_END();
+}
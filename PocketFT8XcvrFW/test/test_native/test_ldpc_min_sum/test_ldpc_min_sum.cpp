@@ -0,0 +1,92 @@
+/**
+ * @brief Host comparison of ms_decode() (fixed-point min-sum) with bp_decode() (float sum-product)
+ *
+ * DISCUSSION:
+ *  Random messages are encoded with encode174(), sent as BPSK over an AWGN channel at a
+ *  range of Eb/N0, and their log-likelihoods normalized as extract_likelihood() does.  Each
+ *  frame is decoded by bp_decode() and, after quantize_likelihood(), by ms_decode().  A frame
+ *  error is a failed parity check or a wrong codeword.  The test reports frame error rate
+ *  against Eb/N0 and the time per decode of each decoder.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_ldpc_min_sum -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+static const int kFrames = 300;  // Frames per Eb/N0
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static bool frame_ok(const uint8_t bits[], const uint8_t plain[], int n_errors) {
+    return n_errors == 0 && memcmp(bits, plain, N) == 0;
+}
+
+/**
+ * @brief Frame error rate against Eb/N0, and decode time, of both decoders
+ */
+void test_ldpc_min_sum_fer(void) {
+    const double ebn0_db[] = {1.0, 2.0, 3.0, 4.0, 5.0};
+    const int num_points = sizeof(ebn0_db) / sizeof(ebn0_db[0]);
+    int bp_errors[num_points], ms_errors[num_points];
+    double bp_ns = 0, ms_ns = 0;
+    BenchNoise noise(174);
+
+    printf("Eb/N0   bp_decode FER   ms_decode FER\n");
+    for (int p = 0; p < num_points; ++p) {
+        bp_errors[p] = ms_errors[p] = 0;
+        for (int frame = 0; frame < kFrames; ++frame) {
+            uint8_t bits[N], plain[N];
+            float log174[N];
+            int8_t llr[N];
+            int n_errors;
+            bench_make_frame(noise, ebn0_db[p], bits, log174);
+
+            BenchTimer tb;
+            bp_decode(log174, kBenchLDPC_iterations, plain, &n_errors);
+            bp_ns += tb.ns();
+            if (!frame_ok(bits, plain, n_errors)) bp_errors[p]++;
+
+            BenchTimer tm;
+            quantize_likelihood(log174, llr);
+            ms_decode(llr, kBenchLDPC_iterations, plain, &n_errors);
+            ms_ns += tm.ns();
+            if (!frame_ok(bits, plain, n_errors)) ms_errors[p]++;
+        }
+        printf("%4.1f dB  %13.3f   %13.3f\n", ebn0_db[p], (double)bp_errors[p] / kFrames, (double)ms_errors[p] / kFrames);
+    }
+    double frames = (double)num_points * kFrames;
+    printf("bp_decode %.0f ns/frame, ms_decode %.0f ns/frame (including quantize_likelihood()), speedup %.2fx\n", bp_ns / frames, ms_ns / frames,
+           bp_ns / ms_ns);
+
+    // Min-sum gives up a fraction of a dB against sum-product, but must still converge on clean frames
+    TEST_ASSERT_TRUE(ms_errors[num_points - 1] <= kFrames / 100);
+    TEST_ASSERT_TRUE(ms_errors[num_points - 2] <= bp_errors[num_points - 3]);
+}
+
+/**
+ * @brief Quantization saturates rather than wrapping
+ */
+void test_ldpc_min_sum_quantize(void) {
+    float log174[N];
+    int8_t llr[N];
+    for (int i = 0; i < N; ++i) log174[i] = (i % 2 ? 1 : -1) * (float)i;
+    quantize_likelihood(log174, llr);
+    TEST_ASSERT_EQUAL_INT(0, llr[0]);
+    TEST_ASSERT_EQUAL_INT(4, llr[1]);
+    TEST_ASSERT_EQUAL_INT(-8, llr[2]);
+    TEST_ASSERT_EQUAL_INT(127, llr[N - 1]);
+    TEST_ASSERT_EQUAL_INT(-127, llr[N - 2]);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ldpc_min_sum_quantize);
+    RUN_TEST(test_ldpc_min_sum_fer);
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+/**
+ * @brief Host tests of the packed LDPC syndrome and the decoders' stall detector
+ *
+ * DISCUSSION:
+ *  ldpc_syndrome_weight() counts failed parity checks over hard decisions packed 32 to a
+ *  word, using each check's precomputed bit mask.  The first test compares it with the
+ *  byte-per-bit walk of kNm it replaced.  The second decodes noise-only candidates and
+ *  BPSK/AWGN frames (see bench_make_frame()) with a range of ldpc_stall_iterations and
+ *  reports the iterations spent on noise against the frame error rate.  The third decodes the
+ *  frames with stall detection off and at LDPC_STALL_ITERATIONS:  the shipped setting must
+ *  decode exactly the same frames, and a build overriding it reports what it loses instead.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_ldpc_syndrome -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+static const int kFrames = 300;  // Frames per setting
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief The original ldpc_check()
+ */
+static int reference_check(const uint8_t plain[]) {
+    int errors = 0;
+    for (int j = 0; j < M; ++j) {
+        uint8_t x = 0;
+        for (int i = 0; i < kNrw[j]; ++i) x ^= plain[kNm[j][i] - 1];
+        if (x != 0) ++errors;
+    }
+    return errors;
+}
+
+/**
+ * @brief Same syndrome weight as the byte walk, for codewords, corrupted codewords and noise
+ */
+void test_ldpc_syndrome_weight(void) {
+    BenchNoise noise(83);
+    for (int trial = 0; trial < 1000; ++trial) {
+        uint8_t plain[N];
+        uint32_t hard[kHard_words];
+        float log174[N];
+        bench_make_frame(noise, 20.0, plain, log174);  // A clean codeword
+        if (trial % 3 == 1) {
+            for (int flips = trial % 7 + 1; flips > 0; --flips) plain[(int)(noise.uniform() * N)] ^= 1;
+        } else if (trial % 3 == 2) {
+            for (int i = 0; i < N; ++i) plain[i] = noise.uniform() < 0.5;
+        }
+        pack_hard_decisions(plain, hard);
+        TEST_ASSERT_EQUAL_INT(reference_check(plain), ldpc_syndrome_weight(hard));
+        if (trial % 3 == 0) TEST_ASSERT_EQUAL_INT(0, ldpc_syndrome_weight(hard));
+    }
+
+    // Time both over random hard decisions (the decoders pack as they make their hard decisions)
+    const int kRepeats = 10000;
+    uint8_t plain[N];
+    uint32_t hard[kHard_words];
+    for (int i = 0; i < N; ++i) plain[i] = noise.uniform() < 0.5;
+    pack_hard_decisions(plain, hard);
+    int reference_sum = 0, packed_sum = 0;
+    BenchTimer tr;
+    for (int r = 0; r < kRepeats; ++r) {
+        plain[r % N] ^= 1;
+        reference_sum += reference_check(plain);
+    }
+    double reference_ns = tr.ns();
+    BenchTimer tp;
+    for (int r = 0; r < kRepeats; ++r) {
+        hard[(r % N) >> 5] ^= 1u << ((r % N) & 31);
+        packed_sum += ldpc_syndrome_weight(hard);
+    }
+    double packed_ns = tp.ns();
+    TEST_ASSERT_EQUAL_INT(reference_sum, packed_sum);
+    printf("syndrome:  byte walk %.0f ns, packed %.0f ns\n", reference_ns / kRepeats, packed_ns / kRepeats);
+}
+
+/**
+ * @brief Iterations on noise-only candidates against frame error rate, by stall setting
+ */
+void test_ldpc_syndrome_stall(void) {
+    const int stall[] = {0, 2, 3, 4, 5};
+    const double ebn0_db[] = {2.0, 3.0};
+
+    printf("stall   noise iterations   FER %.0f dB   FER %.0f dB\n", ebn0_db[0], ebn0_db[1]);
+    for (size_t s = 0; s < sizeof(stall) / sizeof(stall[0]); ++s) {
+        ldpc_stall_iterations = stall[s];
+        BenchNoise noise(1740);  // The same frames for every setting
+        int noise_iterations = 0;
+        int errors[2] = {0, 0};
+        for (int frame = 0; frame < kFrames; ++frame) {
+            uint8_t bits[N], plain[N];
+            float log174[N];
+            int n_errors, iterations;
+
+            // Noise:  normalized as extract_likelihood() would, with no codeword behind it
+            for (int i = 0; i < N; ++i) log174[i] = (float)(4 * noise.gaussian());
+            bp_decode(log174, kBenchLDPC_iterations, plain, &n_errors, &iterations);
+            noise_iterations += iterations;
+
+            for (int p = 0; p < 2; ++p) {
+                bench_make_frame(noise, ebn0_db[p], bits, log174);
+                bp_decode(log174, kBenchLDPC_iterations, plain, &n_errors);
+                bool ok = n_errors == 0 && memcmp(bits, plain, N) == 0;
+                errors[p] += !ok;
+            }
+        }
+        printf("%5d   %16.2f   %9.3f   %9.3f\n", stall[s], (double)noise_iterations / kFrames, (double)errors[0] / kFrames,
+               (double)errors[1] / kFrames);
+    }
+    ldpc_stall_iterations = LDPC_STALL_ITERATIONS;
+}
+
+// Decode the AWGN frames at 2 dB with stall_iterations, noting which decode, and return the frame errors
+static int decode_frames(int stall_iterations, bool decoded[kFrames]) {
+    ldpc_stall_iterations = stall_iterations;
+    BenchNoise noise(1740);  // The same frames for every setting
+    int errors = 0;
+    for (int frame = 0; frame < kFrames; ++frame) {
+        uint8_t bits[N], plain[N];
+        float log174[N];
+        int n_errors;
+        bench_make_frame(noise, 2.0, bits, log174);
+        bp_decode(log174, kBenchLDPC_iterations, plain, &n_errors);
+        decoded[frame] = n_errors == 0 && memcmp(bits, plain, N) == 0;
+        errors += !decoded[frame];
+    }
+    ldpc_stall_iterations = LDPC_STALL_ITERATIONS;
+    return errors;
+}
+
+/**
+ * @brief LDPC_STALL_ITERATIONS decodes the same frames as stall detection off, unless overridden
+ */
+void test_ldpc_syndrome_default_stall(void) {
+    static bool without_stall[kFrames], with_stall[kFrames];
+    int errors_off = decode_frames(0, without_stall);
+    int errors_default = decode_frames(LDPC_STALL_ITERATIONS, with_stall);
+    int mismatches = 0;
+    for (int frame = 0; frame < kFrames; ++frame) mismatches += with_stall[frame] != without_stall[frame];
+    printf("stall %d:  FER %.3f against %.3f without stall detection, %d frames decode differently\n", LDPC_STALL_ITERATIONS,
+           (double)errors_default / kFrames, (double)errors_off / kFrames, mismatches);
+
+#if LDPC_STALL_ITERATIONS != 0
+    TEST_IGNORE_MESSAGE("LDPC_STALL_ITERATIONS is overridden, so its FER is reported rather than asserted");
+#else
+    TEST_ASSERT_EQUAL_INT(0, mismatches);
+#endif
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ldpc_syndrome_weight);
+    RUN_TEST(test_ldpc_syndrome_stall);
+    RUN_TEST(test_ldpc_syndrome_default_stall);
+    return UNITY_END();
+}
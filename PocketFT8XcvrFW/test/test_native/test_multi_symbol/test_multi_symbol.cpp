@@ -0,0 +1,106 @@
+/**
+ * @brief Host tests and cost/benefit benchmark of multi-symbol soft demodulation
+ *
+ * DISCUSSION:
+ *  extract_likelihood() can demodulate likelihood_symbols (1, 2 or 3) data symbols together,
+ *  taking each bit's likelihood over all 8^n tone combinations of the group.  The spectrogram
+ *  holds only power (dB) per bin, so a combination's metric is the sum of its symbols' tone
+ *  powers and its maximum separates into per-symbol maxima:  the other symbols' terms cancel
+ *  in max(bit set) - max(bit clear), and the likelihoods equal the single-symbol ones.  The
+ *  tests confirm that on random spectrograms, then replay the bench timeslots in every mode
+ *  and report decodes and extract_likelihood()'s cost per candidate.  Any gain from groups
+ *  would need the symbols' complex amplitudes (coherent combining), which the spectrogram
+ *  does not keep.  The multi-symbol path is therefore built only with FT8_LIKELIHOOD_SYMBOLS
+ *  of 2 or 3, and without it both tests are ignored.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_multi_symbol -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+static std::vector<std::vector<int16_t> > slots;  // Timeslots of audio under test
+#if FT8_LIKELIHOOD_SYMBOLS > 1
+static uint8_t spectrogram[kBenchSpectrogramSize];
+#endif
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief Groups of 2 and 3 symbols reproduce the single-symbol likelihoods of random spectrograms
+ */
+void test_multi_symbol_likelihoods(void) {
+#if FT8_LIKELIHOOD_SYMBOLS < 2
+    TEST_IGNORE_MESSAGE("Multi-symbol demodulation is built only with -D FT8_LIKELIHOOD_SYMBOLS=2 or 3");
+#else
+    BenchNoise noise(0x18);
+    for (int i = 0; i < kBenchSpectrogramSize; ++i) spectrogram[i] = (uint8_t)(256 * noise.uniform());
+
+    for (int c = 0; c < 200; ++c) {
+        Candidate cand;
+        cand.score = 0;
+        cand.time_offset = (int16_t)((ft8_msg_samples - 79) * noise.uniform());
+        cand.freq_offset = (int16_t)(ft8_min_bin + (ft8_buffer - ft8_min_bin - 8) * noise.uniform());
+        cand.time_sub = (uint8_t)(noise.uniform() < 0.5);
+        cand.freq_sub = (uint8_t)(noise.uniform() < 0.5);
+
+        float single[174], multi[174];
+        likelihood_symbols = 1;
+        extract_likelihood(spectrogram, ft8_buffer, cand, kGray_map, single);
+        for (int n = 2; n <= 3; ++n) {
+            likelihood_symbols = n;
+            extract_likelihood(spectrogram, ft8_buffer, cand, kGray_map, multi);
+            for (int i = 0; i < N; ++i) TEST_ASSERT_EQUAL_FLOAT(single[i], multi[i]);
+        }
+    }
+    likelihood_symbols = FT8_LIKELIHOOD_SYMBOLS;
+#endif
+}
+
+/**
+ * @brief Decodes and likelihood cost per candidate over the bench timeslots for 1, 2 and 3 symbols
+ */
+void test_multi_symbol_bench(void) {
+#if FT8_LIKELIHOOD_SYMBOLS < 2
+    TEST_IGNORE_MESSAGE("Multi-symbol demodulation is built only with -D FT8_LIKELIHOOD_SYMBOLS=2 or 3");
+#else
+    int decodes[4] = {0};
+    for (int n = 1; n <= 3; ++n) {
+        likelihood_symbols = n;
+        BenchStats stats;
+        for (size_t s = 0; s < slots.size(); ++s) {
+            bench_build_spectrogram(slots[s], stats);
+            const uint8_t* power = decode_spectrogram();
+#if SPECTROGRAM_4BIT
+            bench_decode_spectrogram((const PackedRow*)power, stats);
+#else
+            bench_decode_spectrogram(power, stats);
+#endif
+            release_spectrogram(power);
+            stats.slots++;
+        }
+        decodes[n] = stats.decodes;
+        printf("%d symbol(s):  %d decodes, extract_likelihood %.0f ns/candidate\n", n, stats.decodes, stats.likelihood_ns / std::max(stats.candidates, 1));
+    }
+    likelihood_symbols = FT8_LIKELIHOOD_SYMBOLS;
+
+    TEST_ASSERT_GREATER_THAN_INT(0, decodes[1]);
+    TEST_ASSERT_EQUAL_INT(decodes[1], decodes[2]);
+    TEST_ASSERT_EQUAL_INT(decodes[1], decodes[3]);
+#endif
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+    bench_load_slots(slots);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_multi_symbol_likelihoods);
+    RUN_TEST(test_multi_symbol_bench);
+    return UNITY_END();
+}
@@ -0,0 +1,110 @@
+/**
+ * @brief Host tests of the ordered-statistics decoding fallback
+ *
+ * DISCUSSION:
+ *  Weak BPSK/AWGN frames carrying a valid CRC (see bench_make_frame()) are decoded with
+ *  bp_decode().  The near misses, which end a few parity checks short, are passed to
+ *  osd_decode() at orders 1 and 2.  The test counts the frames each order recovers and
+ *  any wrong codewords it returns, and reports the mean and worst time per invocation.
+ *  Noise-only likelihoods measure how often the CRC lets a false decode through.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_osd -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+#include "osd.h"
+
+static const int kFrames = 400;
+static const int kNear_miss_errors = 12;  // Mirror kOSD_max_errors in src/decode_ft8.cpp
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief Clean frames decode at every order
+ */
+void test_osd_clean(void) {
+    BenchNoise noise(7);
+    for (int frame = 0; frame < 20; ++frame) {
+        uint8_t bits[N], plain[N];
+        float log174[N];
+        bench_make_frame(noise, 8.0, bits, log174, true);
+        for (int order = 0; order <= 2; ++order) {
+            TEST_ASSERT_TRUE(osd_decode(log174, order, plain));
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(bits, plain, N);
+        }
+    }
+}
+
+/**
+ * @brief Near misses recovered by order, cost per invocation
+ */
+void test_osd_near_misses(void) {
+    const double ebn0_db[] = {1.5, 2.0, 2.5};
+    int near_misses = 0, bp_failures = 0;
+    int recovered[3] = {0, 0, 0}, wrong[3] = {0, 0, 0};
+    double total_ns[3] = {0, 0, 0}, worst_ns[3] = {0, 0, 0};
+    BenchNoise noise(14);
+
+    for (size_t p = 0; p < sizeof(ebn0_db) / sizeof(ebn0_db[0]); ++p) {
+        for (int frame = 0; frame < kFrames; ++frame) {
+            uint8_t bits[N], plain[N];
+            float log174[N];
+            int n_errors;
+            bench_make_frame(noise, ebn0_db[p], bits, log174, true);
+            bp_decode(log174, kBenchLDPC_iterations, plain, &n_errors);
+            if (n_errors == 0) continue;
+            bp_failures++;
+            if (n_errors > kNear_miss_errors) continue;
+            near_misses++;
+
+            for (int order = 1; order <= 2; ++order) {
+                BenchTimer t;
+                bool ok = osd_decode(log174, order, plain);
+                double ns = t.ns();
+                total_ns[order] += ns;
+                if (ns > worst_ns[order]) worst_ns[order] = ns;
+                if (ok && memcmp(bits, plain, N) == 0) recovered[order]++;
+                if (ok && memcmp(bits, plain, N) != 0) wrong[order]++;
+            }
+        }
+    }
+
+    printf("%d bp_decode failures, %d near misses (n_errors <= %d)\n", bp_failures, near_misses, kNear_miss_errors);
+    for (int order = 1; order <= 2; ++order) {
+        printf("OSD-%d:  recovered %d, wrong %d, %.0f ns/invocation mean, %.0f ns worst\n", order, recovered[order], wrong[order],
+               total_ns[order] / (near_misses ? near_misses : 1), worst_ns[order]);
+    }
+    TEST_ASSERT_GREATER_THAN_INT(0, recovered[1]);
+    TEST_ASSERT_TRUE(recovered[2] >= recovered[1]);
+}
+
+/**
+ * @brief The CRC rejects nearly all codewords OSD finds in noise
+ */
+void test_osd_noise(void) {
+    const int kNoise_frames = 1000;
+    int false_decodes = 0;
+    BenchNoise noise(99);
+    for (int frame = 0; frame < kNoise_frames; ++frame) {
+        float log174[N];
+        uint8_t plain[N];
+        for (int i = 0; i < N; ++i) log174[i] = (float)(4 * noise.gaussian());
+        false_decodes += osd_decode(log174, 2, plain);
+    }
+    printf("OSD-2 on noise:  %d false decodes in %d\n", false_decodes, kNoise_frames);
+    TEST_ASSERT_TRUE(false_decodes <= kNoise_frames / 100);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_osd_clean);
+    RUN_TEST(test_osd_near_misses);
+    RUN_TEST(test_osd_noise);
+    return UNITY_END();
+}
@@ -0,0 +1,133 @@
+/**
+ * @brief Host tests of payload-keyed duplicate rejection
+ *
+ * DISCUSSION:
+ *  ft8_decode() keeps the 96-bit a91[] payloads of a timeslot's decodes in a PayloadSet, so
+ *  another candidate on the same signal is rejected after its CRC check and before it is
+ *  unpacked.  Payloads differing in any one of their 77 bits must stay distinct, and the set
+ *  must hold kPayload_set_limit payloads.  The test also reports the cost of rejecting a
+ *  repeat compared with the unpack77_fields(), snprintf() and strcmp() it replaces.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_payload_set -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void random_payload(BenchNoise& noise, uint8_t a91[]) {
+    for (int j = 0; j < K_BYTES; ++j) a91[j] = (uint8_t)(256 * noise.uniform());
+    a91[9] &= 0xF8;  // 77 bits, CRC cleared
+    a91[10] = 0;
+    a91[11] = 0;
+}
+
+/**
+ * @brief Repeats are rejected and payloads one bit apart are not
+ */
+void test_payload_set_duplicates(void) {
+    PayloadSet set;
+    payload_set_clear(set);
+    uint8_t a91[K_BYTES];
+    TEST_ASSERT_EQUAL_INT(0, pack77("CQ K1ABC FN42", a91));
+    a91[10] = a91[11] = 0;
+    TEST_ASSERT_TRUE(payload_set_insert(set, a91));
+    TEST_ASSERT_FALSE(payload_set_insert(set, a91));
+
+    for (int bit = 0; bit < 77; ++bit) {
+        uint8_t flipped[K_BYTES];
+        memcpy(flipped, a91, sizeof(flipped));
+        flipped[bit >> 3] ^= 0x80 >> (bit & 7);
+        TEST_ASSERT_TRUE(payload_set_insert(set, flipped));
+        TEST_ASSERT_FALSE(payload_set_insert(set, flipped));
+    }
+    TEST_ASSERT_EQUAL_INT(78, set.count);
+
+    payload_set_clear(set);
+    TEST_ASSERT_EQUAL_INT(0, set.count);
+    TEST_ASSERT_TRUE(payload_set_insert(set, a91));
+}
+
+/**
+ * @brief The set holds kPayload_set_limit payloads and then refuses more
+ */
+void test_payload_set_limit(void) {
+    PayloadSet set;
+    payload_set_clear(set);
+    BenchNoise noise(0x21);
+    static uint8_t payloads[kPayload_set_limit + 1][12];  // [][K_BYTES]
+    for (int i = 0; i <= kPayload_set_limit; ++i) random_payload(noise, payloads[i]);
+
+    for (int i = 0; i < kPayload_set_limit; ++i) TEST_ASSERT_TRUE(payload_set_insert(set, payloads[i]));
+    for (int i = 0; i < kPayload_set_limit; ++i) TEST_ASSERT_FALSE(payload_set_insert(set, payloads[i]));
+    TEST_ASSERT_FALSE(payload_set_insert(set, payloads[kPayload_set_limit]));
+    TEST_ASSERT_EQUAL_INT(kPayload_set_limit, set.count);
+}
+
+/**
+ * @brief Cost of rejecting a repeat by payload and by unpacked text
+ */
+void test_payload_set_timing(void) {
+    const int kMessages = 9;
+    const int kRepeats = 20000;
+    static const char* kTexts[kMessages] = {"CQ K1ABC FN42", "K1ABC W9XYZ EN37", "W9XYZ K1ABC -12", "K1ABC W9XYZ R-07", "W9XYZ K1ABC RR73",
+                                            "CQ DX JA1XYZ PM95", "G4ABC JA1XYZ +02", "JA1XYZ G4ABC R-15", "CQ POTA KQ7B DN15"};
+    static uint8_t a91[kMessages][12];  // [][K_BYTES]
+    for (int m = 0; m < kMessages; ++m) {
+        TEST_ASSERT_EQUAL_INT(0, pack77(kTexts[m], a91[m]));
+        a91[m][10] = a91[m][11] = 0;
+    }
+    int rejected = 0;
+
+    // Each message's repeat checked against all the timeslot's messages
+    BenchTimer tp;
+    for (int r = 0; r < kRepeats; ++r) {
+        PayloadSet set;
+        payload_set_clear(set);
+        for (int m = 0; m < kMessages; ++m) payload_set_insert(set, a91[m]);
+        for (int m = 0; m < kMessages; ++m) rejected += !payload_set_insert(set, a91[m]);
+    }
+    double payload_ns = tp.ns() / (kRepeats * kMessages);
+
+    char decoded[kMessages][40];  // Room for any three fields
+    for (int m = 0; m < kMessages; ++m) {
+        char field1[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE], field2[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE], field3[FTX_REPORTS_BFRSIZE];
+        MsgType msgType;
+        unpack77_fields(a91[m], field1, field2, field3, &msgType);
+        snprintf(decoded[m], sizeof(decoded[m]), "%s %s %s ", field1, field2, field3);
+    }
+    BenchTimer tt;
+    for (int r = 0; r < kRepeats / 20; ++r) {
+        for (int m = 0; m < kMessages; ++m) {
+            char field1[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE], field2[FTX_NONSTANDARD_BRACKETED_CALLSIGN_BFRSIZE], field3[FTX_REPORTS_BFRSIZE];
+            char message[40];
+            MsgType msgType;
+            unpack77_fields(a91[m], field1, field2, field3, &msgType);
+            snprintf(message, sizeof(message), "%s %s %s ", field1, field2, field3);
+            for (int i = 0; i < kMessages; ++i) {
+                if (strcmp(decoded[i], message) == 0) {
+                    rejected--;
+                    break;
+                }
+            }
+        }
+    }
+    double text_ns = tt.ns() / (kRepeats / 20 * kMessages);
+
+    printf("Repeat rejected by payload %.0f ns (including its first insertion), by unpacked text %.0f ns\n", payload_ns, text_ns);
+    TEST_ASSERT_EQUAL_INT(kRepeats * kMessages - kRepeats / 20 * kMessages, rejected);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_payload_set_duplicates);
+    RUN_TEST(test_payload_set_limit);
+    RUN_TEST(test_payload_set_timing);
+    return UNITY_END();
+}
@@ -0,0 +1,220 @@
+/**
+ * @brief Host tests of successive interference cancellation (SIC) with subtract_signal()
+ *
+ * DISCUSSION:
+ *  After each pass decodes its messages, subtract_signal() removes their tones from the
+ *  spectrogram, and the next pass runs find_sync() again over what remains.  This mirrors
+ *  ft8_decode()'s config.sicPasses.  The test checks that a decoded signal leaves no candidate
+ *  behind it, and that later passes keep every message the first decoded.  It also checks that
+ *  they recover weak signals masked by strong ones a few tones away.  It reports the decodes per
+ *  pass and the cost of the extra passes.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_sic -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+static const int kMax_passes = 3;  // kMax_sic_passes
+
+static std::vector<std::vector<int16_t> > slots;  // Timeslots of audio under test
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief A timeslot of strong signals, each with a weak one four tones above it, in white noise
+ */
+static void make_masked_slot(uint32_t seed, std::vector<int16_t>& samples) {
+    static const char* strong[] = {"CQ K1ABC FN42", "CQ DX JA1XYZ PM95", "CQ EA8BFK IL38"};
+    static const char* weak[] = {"KQ7B W1AW FN31", "K9AN K1JT R-12", "N0CALL G4ABC RR73"};
+    const double sigma = 4000;
+    const double strong_snr = pow(10.0, -4 / 10.0), weak_snr = pow(10.0, -12 / 10.0);
+    BenchNoise noise(seed);
+
+    std::vector<double> audio(kBenchSlotSamples, 0.0);
+    for (int i = 0; i < 3; ++i) {
+        double freq_hz = 600.0 * (i + 1) + (seed % 4) * 50.0;
+        double start_s = 0.5 + 0.02 * ((seed + i) % 6 + 1);
+        bench_add_signal(strong[i], freq_hz, 0.5, sqrt(2 * strong_snr * sigma * sigma * 2500.0 / (kBenchSampleRate / 2)), audio);
+        bench_add_signal(weak[i], freq_hz + 4 * 6.25, start_s, sqrt(2 * weak_snr * sigma * sigma * 2500.0 / (kBenchSampleRate / 2)), audio);
+    }
+
+    samples.resize(kBenchSlotSamples);
+    for (int n = 0; n < kBenchSlotSamples; ++n) {
+        double x = audio[n] + sigma * noise.gaussian();
+        samples[n] = (int16_t)((x > 32767) ? 32767 : ((x < -32768) ? -32768 : x));
+    }
+}
+
+// Decode the spectrogram in passes, subtracting each pass's messages before the next
+template <typename Entry>
+static int decode_passes(Entry* power, int passes, int per_pass[], PayloadSet& decoded, double* extra_ns) {
+    Candidate sources[kPayload_set_limit];  // The candidates each message was decoded from
+    uint8_t payloads[kPayload_set_limit][12];
+    int num_decoded = 0, subtracted = 0;
+    payload_set_clear(decoded);
+    for (int pass = 0; pass < passes; ++pass) per_pass[pass] = 0;
+
+    for (int pass = 0; pass < passes; ++pass) {
+        BenchTimer t;
+        if (pass > 0) {
+            if (subtracted == num_decoded) break;
+            for (; subtracted < num_decoded; ++subtracted) {
+                uint8_t tones[79];
+                genft8(payloads[subtracted], tones);
+                subtract_signal(power, ft8_msg_samples, ft8_buffer, sources[subtracted], tones);
+            }
+        }
+
+        Candidate candidate_list[kBenchCandidate_pool];
+        int runs_saved;
+        int num_candidates = find_sync(power, ft8_msg_samples, ft8_buffer, kCostas_map, kBenchCandidate_pool, candidate_list, kBenchMin_score);
+        num_candidates = suppress_candidates(candidate_list, num_candidates, kBenchMax_candidates, &runs_saved);
+        for (int c = 0; c < num_candidates && num_decoded < kPayload_set_limit; ++c) {
+            float log174[174];
+            uint8_t plain[174];
+            int n_errors;
+            extract_likelihood(power, ft8_buffer, candidate_list[c], kGray_map, log174);
+            bp_decode(log174, kBenchLDPC_iterations, plain, &n_errors);
+            if (n_errors > 0) continue;
+
+            uint8_t* a91 = payloads[num_decoded];
+            pack_bits(plain, K, a91);
+            uint16_t chksum = ((a91[9] & 0x07) << 11) | (a91[10] << 3) | (a91[11] >> 5);
+            a91[9] &= 0xF8;
+            a91[10] = 0;
+            a91[11] = 0;
+            if (chksum != crc(a91, 96 - 14) || !payload_set_insert(decoded, a91)) continue;
+            sources[num_decoded++] = candidate_list[c];
+            per_pass[pass]++;
+        }
+        if (pass > 0) *extra_ns += t.ns();
+    }
+    return num_decoded;
+}
+
+// Build the spectrogram of samples and decode it in up to passes passes
+static int decode_slot(const std::vector<int16_t>& samples, int passes, int per_pass[], PayloadSet& decoded, double* extra_ns) {
+    BenchStats spectrum;
+    bench_build_spectrogram(samples, spectrum);
+    uint8_t* power = (uint8_t*)decode_spectrogram();  // The decoder owns its bank until release_spectrogram()
+#if SPECTROGRAM_4BIT
+    int decodes = decode_passes((PackedRow*)power, passes, per_pass, decoded, extra_ns);
+#else
+    int decodes = decode_passes(power, passes, per_pass, decoded, extra_ns);
+#endif
+    release_spectrogram(power);
+    return decodes;
+}
+
+// Whether every payload in subset is also in set
+static bool payloads_within(const PayloadSet& subset, const PayloadSet& set) {
+    for (int i = 0; i < kPayload_set_slots; ++i) {
+        if (!subset.used[i]) continue;
+        uint8_t a91[12];
+        for (int w = 0; w < 3; ++w) {
+            for (int b = 0; b < 4; ++b) a91[4 * w + b] = (uint8_t)(subset.key[i][w] >> (24 - 8 * b));
+        }
+        PayloadSet probe = set;
+        if (payload_set_insert(probe, a91)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief A lone signal, once subtracted, leaves find_sync() nothing to find
+ */
+void test_sic_removes_signal(void) {
+    std::vector<double> audio(kBenchSlotSamples, 0.0);
+    bench_add_signal("CQ K1ABC FN42", 1000.0, 0.5, 3000.0, audio);
+    BenchNoise noise(5);
+    std::vector<int16_t> samples(kBenchSlotSamples);
+    for (int n = 0; n < kBenchSlotSamples; ++n) samples[n] = (int16_t)(audio[n] + 4000 * noise.gaussian());
+
+    int per_pass[kMax_passes];
+    PayloadSet decoded;
+    double extra_ns = 0;
+    TEST_ASSERT_EQUAL_INT(1, decode_slot(samples, kMax_passes, per_pass, decoded, &extra_ns));
+    TEST_ASSERT_EQUAL_INT(1, per_pass[0]);
+    TEST_ASSERT_EQUAL_INT(0, per_pass[1]);
+
+    // Nothing near 1000 Hz survives the subtraction with a sync score the decoder would consider
+    BenchStats spectrum;
+    bench_build_spectrogram(samples, spectrum);
+    uint8_t* power = (uint8_t*)decode_spectrogram();
+    Candidate cand[1];
+#if SPECTROGRAM_4BIT
+    PackedRow* rows = (PackedRow*)power;
+#else
+    uint8_t* rows = power;
+#endif
+    TEST_ASSERT_EQUAL_INT(1, find_sync(rows, ft8_msg_samples, ft8_buffer, kCostas_map, 1, cand, kBenchMin_score));
+    uint8_t payload[FTX_PAYLOAD_LENGTH_BYTES], tones[79];
+    pack77("CQ K1ABC FN42", payload);
+    genft8(payload, tones);
+    subtract_signal(rows, ft8_msg_samples, ft8_buffer, cand[0], tones);
+    Candidate after[8];
+    int num_after = find_sync(rows, ft8_msg_samples, ft8_buffer, kCostas_map, 8, after, kBenchMin_score);
+    for (int i = 0; i < num_after; ++i) {
+        float freq_hz = (after[i].freq_offset + after[i].freq_sub / 2.0f) * 6.25f;
+        TEST_ASSERT_TRUE(freq_hz < 950 || freq_hz > 1100 || after[i].score < cand[0].score / 2);
+    }
+    release_spectrogram(power);
+}
+
+/**
+ * @brief Decodes per pass, over the benchmark's timeslots and timeslots of masked signals
+ */
+void test_sic_passes(void) {
+    const int kMasked_slots = 4;
+    int single_total = 0, sic_total = 0, masked_single = 0, masked_sic = 0;
+    int per_pass_total[kMax_passes] = {0};
+    double first_ns = 0, extra_ns = 0;
+
+    for (size_t s = 0; s < slots.size() + kMasked_slots; ++s) {
+        bool masked = s >= slots.size();
+        std::vector<int16_t> samples;
+        if (masked) {
+            make_masked_slot(s - slots.size() + 1, samples);
+        } else {
+            samples = slots[s];
+        }
+
+        int per_pass[kMax_passes];
+        PayloadSet single, sic;
+        double unused = 0;
+        BenchTimer t;
+        int single_decodes = decode_slot(samples, 1, per_pass, single, &unused);
+        first_ns += t.ns();
+        int sic_decodes = decode_slot(samples, kMax_passes, per_pass, sic, &extra_ns);
+        for (int p = 0; p < kMax_passes; ++p) per_pass_total[p] += per_pass[p];
+
+        TEST_ASSERT_TRUE(payloads_within(single, sic));
+        single_total += single_decodes;
+        sic_total += sic_decodes;
+        if (masked) {
+            masked_single += single_decodes;
+            masked_sic += sic_decodes;
+        }
+    }
+
+    printf("Single pass %d decodes, with SIC %d decodes (masked timeslots:  %d, %d), decodes per pass:", single_total, sic_total, masked_single, masked_sic);
+    for (int p = 0; p < kMax_passes; ++p) printf(" %d", per_pass_total[p]);
+    printf("\nFirst pass %.0f ns/timeslot, later passes %.0f ns/timeslot\n", first_ns / (slots.size() + kMasked_slots), extra_ns / (slots.size() + kMasked_slots));
+    TEST_ASSERT_GREATER_THAN_INT(masked_single, masked_sic);
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+    bench_load_slots(slots);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_sic_removes_signal);
+    RUN_TEST(test_sic_passes);
+    return UNITY_END();
+}
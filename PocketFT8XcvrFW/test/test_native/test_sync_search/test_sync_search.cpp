@@ -0,0 +1,63 @@
+/**
+ * @brief Host comparison of find_sync()'s exhaustive and coarse-to-fine searches
+ *
+ * DISCUSSION:
+ *  The coarse-to-fine search scores one eighth of the cells and then refines the best
+ *  peaks.  This test decodes every timeslot with both strategies and reports the trade-off
+ *  between find_sync()'s time and the number of messages decoded.
+ *
+ * USAGE
+ *  pio test -e native -f test_native/test_sync_search -v
+ */
+#include <unity.h>
+
+#include "ft8_bench.h"
+
+static std::vector<std::vector<int16_t> > slots;  // Timeslots of audio under test
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief Decode yield against sync-search time for both strategies
+ */
+void test_sync_search_tradeoff(void) {
+    BenchStats exhaustive, coarse;
+    for (size_t s = 0; s < slots.size(); ++s) {
+        BenchStats spectrum;
+        bench_build_spectrogram(slots[s], spectrum);
+        const uint8_t* power = decode_spectrogram();
+#if SPECTROGRAM_4BIT
+        bench_decode_spectrogram((const PackedRow*)power, exhaustive, false, kSync_exhaustive);
+        bench_decode_spectrogram((const PackedRow*)power, coarse, false, kSync_coarse_to_fine);
+#else
+        bench_decode_spectrogram(power, exhaustive, false, kSync_exhaustive);
+        bench_decode_spectrogram(power, coarse, false, kSync_coarse_to_fine);
+#endif
+        release_spectrogram(power);
+        exhaustive.slots++;
+        coarse.slots++;
+    }
+    bench_report("Exhaustive sync search", exhaustive);
+    bench_report("Coarse-to-fine sync search", coarse);
+
+    double slots_timed = exhaustive.slots ? exhaustive.slots : 1;
+    printf("\nfind_sync:  exhaustive %.0f ns/timeslot %d decodes, coarse-to-fine %.0f ns/timeslot %d decodes, speedup %.2fx\n",
+           exhaustive.sync_ns / slots_timed, exhaustive.decodes, coarse.sync_ns / slots_timed, coarse.decodes, exhaustive.sync_ns / coarse.sync_ns);
+
+    // The coarse search may miss weak or crowded signals, but not the strong ones
+    TEST_ASSERT_GREATER_THAN_INT(0, coarse.decodes);
+    TEST_ASSERT_GREATER_THAN_INT(exhaustive.decodes / 2, coarse.decodes);
+}
+
+int main(int argc, char** argv) {
+    init_DSP();
+    bench_load_slots(slots);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_sync_search_tradeoff);
+    return UNITY_END();
+}